@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+
+// Runs func iterations times and prints the average time of one iteration.
+template<class F> void benchmark(const char* name, int iterations, F func) {
+  func();  // warm up
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    func();
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  printf("%-40s %12.1f ns/iter\n", name, elapsed.count() / iterations);
+}
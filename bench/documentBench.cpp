@@ -0,0 +1,244 @@
+#include "litehtml.h"
+#include "test/container_test.h"
+#include "bench.h"
+using namespace litehtml;
+
+// A synthetic article: nested blocks, inline markup, attributes and long text runs.
+static std::string make_document(int paragraphs) {
+  std::string html = "<html><head><title>Bench</title><style>p { margin: 1em } .note { color: gray }</style></head><body>";
+  for (int i = 0; i < paragraphs; i++) {
+    html += "<div class=\"section\" id=\"s" + std::to_string(i) + "\"><h2>Section heading</h2>";
+    html += "<p class=\"note\" data-index=\"" + std::to_string(i) + "\">Lorem ipsum dolor sit amet, <b>consectetur</b> adipiscing elit, "
+            "sed do eiusmod tempor <a href=\"#s0\">incididunt</a> ut labore et dolore magna aliqua. Ut enim ad minim veniam, "
+            "quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.</p>";
+    html += "<ul><li>One</li><li>Two</li><li>Three</li></ul></div>";
+  }
+  html += "</body></html>";
+  return html;
+}
+
+// Long runs of plain text with some accented words and CJK passages.
+static std::string make_text_document(int paragraphs) {
+  std::string html = "<html><body>";
+  for (int i = 0; i < paragraphs; i++) {
+    html += "<p>";
+    for (int j = 0; j < 20; j++) {
+      html += "The quick brown fox jumps over the lazy dog, caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9. ";
+    }
+    html += "\xE4\xB8\xAD\xE6\x96\x87\xE6\xB5\x8B\xE8\xAF\x95\xE6\x96\x87\xE6\x9C\xAC</p>\n";
+  }
+  html += "</body></html>";
+  return html;
+}
+
+// A few paragraphs of thousands of words each
+static std::string make_long_paragraphs(int paragraphs, int words) {
+  static const char* vocabulary[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit" };
+  std::string html = "<html><body>";
+  for (int i = 0; i < paragraphs; i++) {
+    html += "<p>";
+    for (int j = 0; j < words; j++) {
+      html += vocabulary[(i + j * 7) % 8];
+      html += ' ';
+    }
+    html += "</p>";
+  }
+  html += "</body></html>";
+  return html;
+}
+
+// Tables nested in the cells of tables
+static std::string make_nested_tables(int depth) {
+  if (!depth) return "cell text with a few words";
+  std::string inner = make_nested_tables(depth - 1);
+  return "<table><tr><td>" + inner + "</td><td>side words here</td></tr><tr><td colspan=2>" + inner + "</td></tr></table>";
+}
+
+// Floated thumbnails with captions between paragraphs flowing around them
+static std::string make_gallery(int thumbs) {
+  std::string html = "<html><body><div style=\"float:right;width:150px;height:4000px\">sidebar</div>";
+  for (int i = 0; i < thumbs; i++) {
+    html += "<div style=\"float:left;width:" + std::to_string(60 + i % 5 * 20) + "px;height:" + std::to_string(40 + i % 7 * 10) + "px\">thumb</div>";
+    if (i % 10 == 9) {
+      html += "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore.</p>";
+    }
+  }
+  html += "</body></html>";
+  return html;
+}
+
+// A table whose cells hold paragraphs of text
+static std::string make_text_table(int rows, int cols) {
+  std::string html = "<html><body><table>";
+  for (int row = 0; row < rows; row++) {
+    html += "<tr>";
+    for (int col = 0; col < cols; col++) {
+      html += "<td>";
+      for (int i = 0; i < 20; i++) {
+        html += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore. ";
+      }
+      html += "</td>";
+    }
+    html += "</tr>";
+  }
+  html += "</table></body></html>";
+  return html;
+}
+
+// A log with a line per block
+static std::string make_log(int lines) {
+  std::string html = "<html><body>";
+  for (int i = 0; i < lines; i++) {
+    html += "<div>" + std::to_string(i) + " INFO request handled in 12ms by worker 3</div>";
+  }
+  html += "</body></html>";
+  return html;
+}
+
+// Gives words a width so text wraps into many lines
+class measuring_container : public container_test {
+public:
+  int text_width(const tchar_t* text, uint_ptr hFont) override { return (int)t_strlen(text) * 8; }
+};
+
+void documentBench() {
+  context ctx;
+  container_test container;
+  std::string html = make_document(500);
+  size_t sum = 0;
+  benchmark("createFromUTF8 (500 sections)", 20, [&]() {
+    document::ptr doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+    sum += doc->root() ? 1 : 0;
+  });
+  benchmark("render (500 sections)", 20, [&]() {
+    document::ptr doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+    sum += doc->render(800);
+  });
+  {
+    document::ptr doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+    benchmark("select_all by attribute (500 sections)", 20, [&]() {
+      sum += doc->root()->select_all(_t("p[data-index]")).size();
+      sum += doc->root()->select_all(_t("a[href=\"#s0\"]")).size();
+      sum += doc->root()->select_all(_t(".note")).size();
+    });
+  }
+  {
+    // only the destruction is timed, documents are created beforehand
+    std::vector<document::ptr> docs;
+    for (int i = 0; i < 20; i++) {
+      docs.push_back(document::createFromUTF8(html.c_str(), &container, &ctx));
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    docs.clear();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%-40s %12.1f ns/iter\n", "~document (500 sections)", elapsed.count() / 20);
+  }
+  std::string text = make_text_document(200);
+  benchmark("createFromUTF8 (text, 200 paragraphs)", 20, [&]() {
+    document::ptr doc = document::createFromUTF8(text.c_str(), &container, &ctx);
+    sum += doc->root() ? 1 : 0;
+  });
+  measuring_container measuring;
+  benchmark("render (text, 200 paragraphs)", 20, [&]() {
+    document::ptr doc = document::createFromUTF8(text.c_str(), &measuring, &ctx);
+    sum += doc->render(600);
+  });
+  {
+    context block_ctx;
+    block_ctx.load_master_stylesheet(_t("html, body, div, p { display: block }"));
+    // only the first layout of a document is timed, the documents are created beforehand
+    std::string log = make_log(10000);
+    for (int partial = 0; partial < 2; partial++) {
+      std::vector<document::ptr> docs;
+      for (int i = 0; i < 3; i++) {
+        docs.push_back(document::createFromUTF8(log.c_str(), &measuring, &block_ctx));
+      }
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for (auto& doc : docs) {
+        sum += partial ? doc->render_partial(800, 600) : doc->render(800);
+      }
+      std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      printf("%-40s %12.1f ns/iter\n", partial ? "render_partial (log, first screen)" : "render (log, 10000 lines)", elapsed.count() / docs.size());
+    }
+    {
+      // the layout spread over frames of 2 ms, the longest one is printed
+      document::ptr doc = document::createFromUTF8(log.c_str(), &measuring, &block_ctx);
+      double longest = 0;
+      int frames = 0;
+      do {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sum += doc->render_partial(800, start + std::chrono::milliseconds(2));
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        longest = std::max(longest, elapsed.count());
+        frames++;
+      } while (!doc->is_layout_complete());
+      printf("%-40s %12.1f ns (%d frames)\n", "render_partial (log, 2 ms frames)", longest, frames);
+    }
+    std::string paragraphs = make_long_paragraphs(10, 20000);
+    document::ptr doc = document::createFromUTF8(paragraphs.c_str(), &measuring, &block_ctx);
+    int width = 800;
+    benchmark("render (long paragraphs, 10 x 20000 words)", 20, [&]() {
+      doc->root()->invalidate_layout();
+      sum += doc->render(width++);
+    });
+  }
+  {
+    // block layout, the unchanged sections keep their layout
+    context block_ctx;
+    block_ctx.load_master_stylesheet(_t("html, body, div, p, h2, ul { display: block } li { display: list-item }"));
+    document::ptr doc = document::createFromUTF8(html.c_str(), &measuring, &block_ctx);
+    doc->render(800);
+    element::ptr p = doc->root()->select_one(_t("#s250 p"));
+    benchmark("render (all restyled, 500 sections)", 20, [&]() {
+      doc->root()->parse_styles();
+      sum += doc->render(800);
+    });
+    benchmark("render (one restyled, 500 sections)", 20, [&]() {
+      p->parse_styles();
+      sum += doc->render(800);
+    });
+    // the sections have a width of their own, resizing the window moves them only
+    std::string fixed = html;
+    fixed.replace(fixed.find("</style>"), 0, " .section { width: 700px }");
+    doc = document::createFromUTF8(fixed.c_str(), &measuring, &block_ctx);
+    int width = 800;
+    benchmark("resize (fixed width sections)", 20, [&]() {
+      sum += doc->render(width++);
+    });
+  }
+  {
+    context table_ctx;
+    table_ctx.load_master_stylesheet(_t("html, body { display: block } table { display: table } tr { display: table-row } td { display: table-cell }"));
+    std::string tables = "<html><body>" + make_nested_tables(5) + "</body></html>";
+    benchmark("render (tables nested 5 deep)", 20, [&]() {
+      document::ptr doc = document::createFromUTF8(tables.c_str(), &measuring, &table_ctx);
+      sum += doc->render(800);
+    });
+    std::string text_table = make_text_table(16, 4);
+    document::ptr doc = document::createFromUTF8(text_table.c_str(), &measuring, &table_ctx);
+    benchmark("render (table of 64 text cells)", 20, [&]() {
+      doc->root()->invalidate_layout();
+      sum += doc->render(1200);
+    });
+    doc->set_layout_threads(4);
+    benchmark("render (table of 64 text cells, 4 threads)", 20, [&]() {
+      doc->root()->invalidate_layout();
+      sum += doc->render(1200);
+    });
+  }
+  {
+    context float_ctx;
+    float_ctx.load_master_stylesheet(_t("html, body, div, p { display: block }"));
+    std::string gallery = make_gallery(1000);
+    benchmark("render (floats gallery, 1000 floats)", 20, [&]() {
+      document::ptr doc = document::createFromUTF8(gallery.c_str(), &measuring, &float_ctx);
+      sum += doc->render(800);
+    });
+  }
+  document::ptr doc = document::createFromUTF8(text.c_str(), &container, &ctx);
+  printf("%-40s %12zu bytes (input %zu)\n", "parse arena high water (text)", doc->parse_arena_high_water(), text.size());
+  doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+  printf("%-40s %12zu bytes (input %zu)\n", "parse arena high water (sections)", doc->parse_arena_high_water(), html.size());
+  printf("%-40s %12zu bytes\n", "elements arena (sections)", doc->elements_arena_used());
+  printf("checksum %zu\n", sum);
+}
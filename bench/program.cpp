@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+void webColorBench();
+void documentBench();
+void tokenizerBench();
+
+int main(int argc, char **argv) {
+	int benchId = argv[1] ? atoi(argv[1]) : 0;
+	// Launch benchmark, 0 runs all of them
+	bool all = benchId == 0;
+	if (all || benchId == 1) webColorBench();
+	if (all || benchId == 2) documentBench();
+	if (all || benchId == 3) tokenizerBench();
+	if (benchId < 0 || benchId > 3) printf("Unknown benchmark.\n");
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include <string>
+#include "litehtml.h"
+#include "litehtml/utf8_strings.h"
+#include "gumbo.h"
+#include "bench.h"
+
+// Text-heavy markup: long paragraphs with a little inline markup and entities.
+static std::string make_text_markup(int paragraphs) {
+  std::string html = "<html><body>";
+  for (int i = 0; i < paragraphs; i++) {
+    html += "<p>";
+    for (int j = 0; j < 20; j++) {
+      html += "The quick brown fox jumps over the lazy dog, and then runs back again. ";
+    }
+    html += "Some <b>bold</b> and <i>italic</i> text &amp; an entity.</p>\n";
+  }
+  html += "</body></html>";
+  return html;
+}
+
+static void parse_throughput(const char* name, const std::string& html) {
+  size_t sum = 0;
+  const int iterations = 20;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    GumboOutput* output = gumbo_parse_with_options(&kGumboDefaultOptions, html.c_str(), html.size());
+    sum += output->errors.length;
+    gumbo_destroy_output(&kGumboDefaultOptions, output);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  printf("%-40s %12.1f MB/s (errors %zu)\n", name, html.size() * iterations / elapsed.count() / (1024 * 1024), sum);
+}
+
+void tokenizerBench() {
+  parse_throughput("gumbo_parse (text, 500 paragraphs)", make_text_markup(500));
+  std::string markup = "<html><body>";
+  for (int i = 0; i < 5000; i++) {
+    markup += "<div class=\"c\"><span>x</span><a href=\"#\">y</a></div>";
+  }
+  markup += "</body></html>";
+  parse_throughput("gumbo_parse (markup, 5000 blocks)", markup);
+
+  std::string text;
+  for (int i = 0; i < 2000; i++) {
+    text += "The quick brown fox jumps over the lazy dog, caf\xC3\xA9 na\xC3\xAFve. ";
+  }
+  size_t length = 0;
+  benchmark("utf8_to_wchar (140 KB, mostly ASCII)", 50, [&]() {
+    litehtml::utf8_to_wchar wide(text.c_str());
+    length += wcslen(wide);
+  });
+  printf("checksum %zu\n", length);
+}
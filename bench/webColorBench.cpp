@@ -0,0 +1,25 @@
+#include "litehtml.h"
+#include "test/container_test.h"
+#include "bench.h"
+using namespace litehtml;
+
+static const tchar_t* colors[] = {
+  _t("#fff"), _t("#F0F8FF"), _t("rgb(255, 0, 255)"), _t("rgba(0, 0, 0, 0.5)"),
+  _t("red"), _t("black"), _t("transparent"), _t("LightGoldenRodYellow"),
+  _t("cornflowerblue"), _t("unknown"),
+};
+
+void webColorBench() {
+  container_test container;
+  unsigned int sum = 0;
+  for (const tchar_t* clr : colors) {
+    benchmark(clr, 1000000, [&]() {
+      web_color c = web_color::from_string(clr, &container);
+      sum += c.red + c.green + c.blue + c.alpha;
+    });
+  }
+  benchmark("is_color (all)", 1000000, [&]() {
+    for (const tchar_t* clr : colors) sum += web_color::is_color(clr);
+  });
+  printf("checksum %u\n", sum);
+}
@@ -80,6 +80,7 @@ public:
 	virtual void						set_clip(const litehtml::position& pos, const litehtml::border_radiuses& bdr_radius, bool valid_x, bool valid_y) override;
 	virtual void						del_clip() override;
 	virtual std::shared_ptr<litehtml::element>	create_element(const litehtml::tchar_t* tag_name, const litehtml::string_map& attributes, const std::shared_ptr<litehtml::document>& doc) override;
+	virtual bool						creates_elements() const override { return false; }
 	virtual void						get_media_features(litehtml::media_features& media) const override;
 	virtual void						get_language(litehtml::tstring& language, litehtml::tstring & culture) const override;
 	virtual void						link(const std::shared_ptr<litehtml::document>& doc, const litehtml::element::ptr& el) override;
@@ -29,7 +29,28 @@ void container_test::link(const std::shared_ptr<litehtml::document>& ptr, const
 void container_test::on_anchor_click(const litehtml::tchar_t* url, const litehtml::element::ptr& el) {}  //: on_anchor_click
 void container_test::set_cursor(const litehtml::tchar_t* cursor) {}                                      //: set_cursor
 void container_test::transform_text(litehtml::tstring& text, litehtml::text_transform tt) {}
-void container_test::import_css(litehtml::tstring& text, const litehtml::tstring& url, litehtml::tstring& baseurl) {}  //: import_css
+void container_test::import_css(litehtml::tstring& text, const litehtml::tstring& url, litehtml::tstring& baseurl) {
+  litehtml::string_map::const_iterator file = m_css_files.find(url);
+  if (file != m_css_files.end()) {
+    text = file->second;
+    baseurl = url;
+  }
+}  //: import_css
+void container_test::import_css_async(const litehtml::tstring& url, const litehtml::tstring& baseurl, const litehtml::import_css_callback& on_loaded) {
+  m_queued_imports.push_back([this, url, baseurl, on_loaded]() {
+    litehtml::tstring text;
+    litehtml::tstring css_baseurl = baseurl;
+    import_css(text, url, css_baseurl);
+    on_loaded(text, css_baseurl);
+  });
+}
+void container_test::add_css_file(const litehtml::tstring& url, const litehtml::tstring& text) { m_css_files[url] = text; }
+size_t container_test::deliver_imports() {
+  std::vector<std::function<void()>> queued;
+  queued.swap(m_queued_imports);
+  for (auto iter = queued.rbegin(); iter != queued.rend(); iter++) (*iter)();
+  return queued.size();
+}
 void container_test::set_clip(const litehtml::position& pos, const litehtml::border_radiuses& bdr_radius, bool valid_x, bool valid_y) {}
 void container_test::del_clip() {}
 void container_test::get_client_rect(litehtml::position& client) const {}  //: get_client_rect
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../include/litehtml.h"
+#include <functional>
 
 class container_test :	public litehtml::document_container
 {
@@ -23,6 +24,7 @@ public:
 	virtual std::shared_ptr<litehtml::element>	create_element(const litehtml::tchar_t *tag_name,
 																 const litehtml::string_map &attributes,
 																 const std::shared_ptr<litehtml::document> &doc) override;
+	virtual bool						creates_elements() const override { return false; }
 	virtual void						get_media_features(litehtml::media_features& media) const override;
 	virtual void						get_language(litehtml::tstring& language, litehtml::tstring & culture) const override;
 	virtual void 						link(const std::shared_ptr<litehtml::document> &ptr, const litehtml::element::ptr& el) override;
@@ -41,4 +43,14 @@ public:
 	virtual	void						set_cursor(const litehtml::tchar_t* cursor) override;
 	virtual void						import_css(litehtml::tstring& text, const litehtml::tstring& url, litehtml::tstring& baseurl) override;
 	virtual void						get_client_rect(litehtml::position& client) const override;
+	virtual void						import_css_async(const litehtml::tstring& url, const litehtml::tstring& baseurl, const litehtml::import_css_callback& on_loaded) override;
+
+	// in-memory stylesheets served by import_css/import_css_async
+	void								add_css_file(const litehtml::tstring& url, const litehtml::tstring& text);
+	// delivers queued import_css_async requests in reverse order; returns the number delivered
+	size_t								deliver_imports();
+
+private:
+	litehtml::string_map				m_css_files;
+	std::vector<std::function<void()>>	m_queued_imports;
 };
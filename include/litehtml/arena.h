@@ -0,0 +1,80 @@
+#ifndef LH_ARENA_H
+#define LH_ARENA_H
+
+#include <cstddef>
+#include <memory>
+
+namespace litehtml
+{
+	// Bump-pointer allocator: memory is taken from large blocks and is only
+	// given back all at once, by clear() or the destructor, or taken again from
+	// the start of the blocks after rewind().
+	class arena
+	{
+		struct block
+		{
+			block*	next;
+			size_t	size;
+			size_t	used;
+		};
+
+		block*	m_blocks;		// the first block, the others follow in the order they were filled
+		block*	m_current;		// the block allocations are taken from
+		size_t	m_block_size;		// the size of the next block
+		size_t	m_max_block_size;
+		size_t	m_used;
+		size_t	m_high_water;
+	public:
+		// Blocks double in size from block_size on, up to max_block_size if that is larger.
+		arena(size_t block_size = 64 * 1024, size_t max_block_size = 0);
+		~arena();
+
+		void*	allocate(size_t size);
+		void	clear();
+		// Makes all memory handed out available again, keeping the blocks. Nothing
+		// is destroyed, here or by clear(), so the arena may only hold objects whose
+		// destructors need not run.
+		void	rewind();
+
+		// bytes handed out since the last clear()
+		size_t	used() const		{ return m_used; }
+		// the largest used() value reached during the arena's lifetime
+		size_t	high_water() const	{ return m_high_water; }
+
+	private:
+		arena(const arena&);
+		arena& operator=(const arena&);
+	};
+
+	// Standard allocator taking memory from a shared arena. deallocate() does nothing,
+	// the memory is released when the last allocator referencing the arena goes away.
+	template<class T> class arena_allocator
+	{
+		template<class U> friend class arena_allocator;
+
+		std::shared_ptr<arena>	m_arena;
+	public:
+		typedef T	value_type;
+
+		explicit arena_allocator(const std::shared_ptr<arena>& a) : m_arena(a) {}
+		template<class U> arena_allocator(const arena_allocator<U>& other) : m_arena(other.m_arena) {}
+
+		T* allocate(size_t n)
+		{
+			void* ret = m_arena->allocate(n * sizeof(T));
+			if (!ret)
+			{
+				throw std::bad_alloc();
+			}
+			return (T*) ret;
+		}
+		void deallocate(T*, size_t)
+		{
+		}
+
+		template<class U> bool operator==(const arena_allocator<U>& other) const { return m_arena == other.m_arena; }
+		template<class U> bool operator!=(const arena_allocator<U>& other) const { return m_arena != other.m_arena; }
+	};
+}
+
+#endif  // LH_ARENA_H
@@ -6,6 +6,8 @@
 
 namespace litehtml
 {
+	class document;
+
 	struct css_border
 	{
 		css_length		width;
@@ -199,19 +201,8 @@ namespace litehtml
 			bottom_right_y	= val.bottom_right_y;
 			return *this;
 		}
-		border_radiuses calc_percents(int width, int height)
-		{
-			border_radiuses ret;
-			ret.bottom_left_x = bottom_left_x.calc_percent(width);
-			ret.bottom_left_y = bottom_left_y.calc_percent(height);
-			ret.top_left_x = top_left_x.calc_percent(width);
-			ret.top_left_y = top_left_y.calc_percent(height);
-			ret.top_right_x = top_right_x.calc_percent(width);
-			ret.top_right_y = top_right_y.calc_percent(height);
-			ret.bottom_right_x = bottom_right_x.calc_percent(width);
-			ret.bottom_right_y = bottom_right_y.calc_percent(height);
-			return ret;
-		}
+		// the radiuses in pixels for a box of the given size, converted by document::cvt_units
+		border_radiuses calc_percents(const document& doc, int font_size, int width, int height) const;
 	};
 
 	struct css_borders
@@ -11,11 +11,17 @@ namespace litehtml
 		box_line
 	};
 
+	// The items of all line boxes of an element, one line after the other
+	typedef std::vector<element*>	line_items;
+
+	// Boxes are taken from the boxes arena of the element laying them out and
+	// are never destroyed, the arena is rewound when the element is laid out
+	// again. They hold raw pointers only: the elements are kept alive by their
+	// parents and text runs.
 	class box
 	{
 	public:
-		typedef std::unique_ptr<litehtml::box>	ptr;
-		typedef std::vector< box::ptr >			vector;
+		typedef std::vector<litehtml::box*>	vector;
 	protected:
 		int		m_box_top;
 		int		m_box_left;
@@ -27,7 +33,8 @@ namespace litehtml
 			m_box_left	= left;
 			m_box_right	= right;
 		}
-		virtual ~box() {}
+		// no virtual destructor: boxes live in the boxes arena of their element, which
+		// never destroys them, so they have to stay trivially destructible
 
 		int		bottom()	{ return m_box_top + height();	}
 		int		top()		{ return m_box_top;				}
@@ -53,7 +60,7 @@ namespace litehtml
 
 	class block_box : public box
 	{
-		element::ptr m_element;
+		element*	m_element;
 	public:
 		block_box(int top, int left, int right) : box(top, left, right)
 		{
@@ -65,6 +72,7 @@ namespace litehtml
 		virtual int					width();
 		virtual void				add_element(const element::ptr &el);
 		virtual bool				can_hold(const element::ptr &el, white_space ws);
+		bool						grow(const element::ptr &el, int width, white_space ws);
 		virtual void				finish(bool last_box = false);
 		virtual bool				is_empty();
 		virtual int					baseline();
@@ -79,7 +87,9 @@ namespace litehtml
 
 	class line_box : public box
 	{
-		elements_vector			m_items;
+		line_items&				m_items;		// the line holds m_items_count items from m_first_item on,
+		size_t					m_first_item;	// while it is the last line they end the array
+		size_t					m_items_count;
 		int						m_height;
 		int						m_width;
 		int						m_line_height;
@@ -87,8 +97,10 @@ namespace litehtml
 		int						m_baseline;
 		text_align				m_text_align;
 	public:
-		line_box(int top, int left, int right, int line_height, font_metrics& fm, text_align align) : box(top, left, right)
+		line_box(int top, int left, int right, int line_height, font_metrics& fm, text_align align, line_items& items) : box(top, left, right), m_items(items)
 		{
+			m_first_item	= items.size();
+			m_items_count	= 0;
 			m_height		= 0;
 			m_width			= 0;
 			m_font_metrics	= fm;
@@ -102,6 +114,10 @@ namespace litehtml
 		virtual int					width();
 		virtual void				add_element(const element::ptr &el);
 		virtual bool				can_hold(const element::ptr &el, white_space ws);
+		bool						grow(const element::ptr &el, int width, white_space ws);
+		// the width left for items on the line
+		int							free_width() const	{ return m_box_right - m_box_left - m_width; }
+		size_t						first_item() const	{ return m_first_item; }
 		virtual void				finish(bool last_box = false);
 		virtual bool				is_empty();
 		virtual int					baseline();
@@ -112,6 +128,7 @@ namespace litehtml
 		virtual void				new_width(int left, int right, elements_vector& els);
 
 	private:
+		element*					item(size_t i) const	{ return m_items[m_first_item + i]; }
 		bool						have_last_space();
 		bool						is_break_only();
 	};
@@ -5,6 +5,16 @@
 
 namespace litehtml
 {
+	// one term of compiled calc() expression that can't be converted into pixels while parsing
+	struct css_calc_term
+	{
+		typedef std::vector<css_calc_term>				vector;
+		typedef std::shared_ptr<const vector>			ptr;
+
+		float		value;
+		css_units	units;
+	};
+
 	class css_length
 	{
 		union
@@ -14,6 +24,9 @@ namespace litehtml
 		};
 		css_units	m_units;
 		bool		m_is_predefined;
+		// calc(): pixels added to the percentage, and the terms to be converted by document::cvt_units
+		float				m_calc_px;
+		css_calc_term::ptr	m_calc_terms;
 	public:
 		css_length();
 		css_length(const css_length& val);
@@ -28,6 +41,9 @@ namespace litehtml
 		css_units	units() const;
 		int			calc_percent(int width) const;
 		void		fromString(const tstring& str, const tstring& predefs = _t(""), int defValue = 0);
+		const css_calc_term::ptr& calc_terms() const;
+	private:
+		bool		parse_calc(const tstring& str);
 	};
 
 	// css_length inlines
@@ -38,6 +54,7 @@ namespace litehtml
 		m_predef		= 0;
 		m_units			= css_units_none;
 		m_is_predefined	= false;
+		m_calc_px		= 0;
 	}
 
 	inline css_length::css_length(const css_length& val)
@@ -51,6 +68,8 @@ namespace litehtml
 		}
 		m_units			= val.m_units;
 		m_is_predefined	= val.m_is_predefined;
+		m_calc_px		= val.m_calc_px;
+		m_calc_terms	= val.m_calc_terms;
 	}
 
 	inline css_length&	css_length::operator=(const css_length& val)
@@ -64,6 +83,8 @@ namespace litehtml
 		}
 		m_units			= val.m_units;
 		m_is_predefined	= val.m_is_predefined;
+		m_calc_px		= val.m_calc_px;
+		m_calc_terms	= val.m_calc_terms;
 		return *this;
 	}
 
@@ -72,6 +93,8 @@ namespace litehtml
 		m_value = val;
 		m_units = css_units_px;
 		m_is_predefined = false;
+		m_calc_px = 0;
+		m_calc_terms = nullptr;
 		return *this;
 	}
 
@@ -84,6 +107,8 @@ namespace litehtml
 	{ 
 		m_predef		= val; 
 		m_is_predefined = true;	
+		m_calc_px		= 0;
+		m_calc_terms	= nullptr;
 	}
 
 	inline int css_length::predef() const
@@ -100,6 +125,8 @@ namespace litehtml
 		m_value			= val; 
 		m_is_predefined = false;	
 		m_units			= units;
+		m_calc_px		= 0;
+		m_calc_terms	= nullptr;
 	}
 
 	inline float css_length::val() const
@@ -122,7 +149,7 @@ namespace litehtml
 		{
 			if(units() == css_units_percentage)
 			{
-				return (int) ((double) width * (double) m_value / 100.0);
+				return (int) ((double) width * (double) m_value / 100.0 + m_calc_px);
 			} else
 			{
 				return (int) val();
@@ -130,6 +157,11 @@ namespace litehtml
 		}
 		return 0;
 	}
+
+	inline const css_calc_term::ptr& css_length::calc_terms() const
+	{
+		return m_calc_terms;
+	}
 }
 
 #endif  // LH_CSS_LENGTH_H
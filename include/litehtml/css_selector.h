@@ -135,13 +135,15 @@ namespace litehtml
 		typedef std::vector<css_attribute_selector>	vector;
 
 		tstring					attribute;
+		const tchar_t*			pooled_attribute;	// attribute from intern_string()
 		tstring					val;
 		string_vector			class_val;
 		attr_select_condition	condition;
 
 		css_attribute_selector()
 		{
-			condition = select_exists;
+			condition			= select_exists;
+			pooled_attribute	= 0;
 		}
 	};
 
@@ -4,6 +4,10 @@
 #include "style.h"
 #include "types.h"
 #include "context.h"
+#include "arena.h"
+#include <mutex>
+#include <atomic>
+#include <chrono>
 
 namespace litehtml
 {
@@ -47,13 +51,20 @@ namespace litehtml
 	};
 
 	class html_tag;
+	class el_image;
+	class task_pool;
+
+	// stylesheets loaded with document_container::import_css_async, keyed by (url, baseurl)
+	typedef std::map<std::pair<tstring, tstring>, css_text>	imported_css_map;
 
 	class document : public std::enable_shared_from_this<document>
 	{
 	public:
 		typedef std::shared_ptr<document>	ptr;
 		typedef std::weak_ptr<document>		weak_ptr;
+		typedef std::function<void(const ptr& doc)>	ready_callback;
 	private:
+		std::shared_ptr<arena>				m_elements_arena;
 		std::shared_ptr<element>			m_root;
 		document_container*					m_container;
 		fonts_map							m_fonts;
@@ -64,11 +75,34 @@ namespace litehtml
 		litehtml::size						m_size;
 		position::vector					m_fixed_boxes;
 		media_query_list::vector			m_media_lists;
+		media_breakpoints					m_media_breakpoints;
+		int_vector							m_media_signature;
 		element::ptr						m_over_element;
 		elements_vector						m_tabular_elements;
+		std::vector<std::weak_ptr<el_image>>	m_images;
+		unsigned int						m_layout_generation;
 		media_features						m_media;
 		tstring                             m_lang;
 		tstring                             m_culture;
+		imported_css_map					m_imported_css;
+		std::mutex							m_imported_css_mutex;
+		int									m_pending_imports;
+		ready_callback						m_on_ready;
+		litehtml::css*						m_user_styles;
+		size_t								m_parse_arena_high_water;
+		std::unique_ptr<task_pool>			m_layout_pool;
+		bool								m_layout_limited;
+		int									m_layout_bottom;
+		bool								m_has_layout_deadline;
+		std::chrono::steady_clock::time_point	m_layout_deadline;
+		int									m_layout_done_bottom;
+		const std::atomic<bool>*			m_layout_cancel;
+		bool								m_layout_stopped;
+		int									m_pending_height;
+		float								m_layout_progress;
+		int									m_layout_width;
+		mutable std::atomic<bool>			m_viewport_units;
+		std::map<tstring, const tchar_t*>	m_attr_names;
 	public:
 		document(litehtml::document_container* objContainer, litehtml::context* ctx);
 		virtual ~document();
@@ -76,13 +110,49 @@ namespace litehtml
 		litehtml::document_container*	container()	{ return m_container; }
 		uint_ptr						get_font(const tchar_t* name, int size, const tchar_t* weight, const tchar_t* style, const tchar_t* decoration, font_metrics* fm);
 		int								render(int max_width, render_type rt = render_all);
+		// Lays out the document like render() does, but stops where the normal flow passes
+		// y = bottom; the content after that point is neither laid out nor drawn. Returns the
+		// height of the whole document estimated from the content laid out so far. Calling it
+		// again with a larger bottom, or calling render(), goes on with the layout: the blocks
+		// laid out before keep their layout.
+		// The layout only stops between the block children of normal flow blocks. The lines
+		// of one paragraph or one <pre> are laid out together, however long, so a long log
+		// in a single block is laid out completely by the first call.
+		int								render_partial(int max_width, int bottom);
+		// Lays out the document like render_partial() until the deadline passes or cancel
+		// (if given, it may be set from any thread) is set: the layout stops after the first
+		// block of the normal flow finished then, so it can be spread over several calls.
+		// Every call lays out some content past the point the last one stopped at, unless
+		// it is cancelled.
+		int								render_partial(int max_width, std::chrono::steady_clock::time_point deadline, const std::atomic<bool>* cancel = 0);
+		// false after render_partial() stopped before the end of the document
+		bool							is_layout_complete() const	{ return !m_layout_stopped; }
+		// the share of the estimated document height laid out, 1 once the layout is complete;
+		// it does not decrease while a partial layout goes on, only when the layout starts
+		// over because the width or the media changed
+		float							layout_progress() const;
+		// render_partial() is running
+		bool							is_layout_limited() const	{ return m_layout_limited; }
+		// The normal flow of a partial layout reached y; true if it has to stop there.
+		bool							should_stop_layout(int y) const;
+		// An element of the normal flow stopped its layout; pending_height is the height its
+		// content that is not laid out would take.
+		void							stop_layout(int pending_height);
 		void							draw(uint_ptr hdc, int x, int y, const position* clip);
 		web_color						get_def_color()	{ return m_def_color; }
 		int								cvt_units(const tchar_t* str, int fontSize, bool* is_percent = 0) const;
 		int								cvt_units(css_length& val, int fontSize, int size = 0) const;
+		// a length in vw, vh, vmin or vmax was converted, so layouts depend on the viewport size
+		bool							uses_viewport_units() const	{ return m_viewport_units; }
+		// the size vw, vh, vmin and vmax are resolved against
+		litehtml::size					viewport_size() const;
 		int								width() const;
 		int								height() const;
 		void							add_stylesheet(const tchar_t* str, const tchar_t* baseurl, const tchar_t* media);
+		void							import_css(tstring& text, const tstring& url, tstring& baseurl);
+		// Adds the styles to a loaded document and restyles the elements they match.
+		// Returns true if the styles of some element changed.
+		bool							append_stylesheet(const tchar_t* str, const tchar_t* baseurl = 0, const tchar_t* media = 0);
 		bool							on_mouse_over(int x, int y, int client_x, int client_y, position::vector& redraw_boxes);
 		bool							on_lbutton_down(int x, int y, int client_x, int client_y, position::vector& redraw_boxes);
 		bool							on_lbutton_up(int x, int y, int client_x, int client_y, position::vector& redraw_boxes);
@@ -96,18 +166,64 @@ namespace litehtml
 		bool							lang_changed();
 		bool                            match_lang(const tstring & lang);
 		void							add_tabular(const element::ptr& el);
+		void							add_image(const std::shared_ptr<el_image>& el);
+		// The copy of a lowercase attribute name the elements keep: the pooled one if a
+		// selector uses the name (is_pooled is set then), otherwise one from the element
+		// arena, shared by the elements of the document.
+		const tchar_t*					attribute_name(const tstring& name, bool& is_pooled);
+		// incremented when render() starts and ends; see element::invalidate_layout()
+		unsigned int					layout_generation() const { return m_layout_generation; }
 		const element::const_ptr		get_over_element() const { return m_over_element; }
+		// peak number of bytes gumbo took from its arena while parsing this document
+		size_t							parse_arena_high_water() const { return m_parse_arena_high_water; }
+		// bytes taken by the elements created from markup
+		size_t							elements_arena_used() const { return m_elements_arena->used(); }
+		// Lays out the cells of tables on up to count threads, the one calling render()
+		// included; 0 or 1 lays out everything on the calling thread. The boxes are the
+		// same either way. With more threads the container's text_width, get_image_size,
+		// get_client_rect, pt_to_px and get_default_font_size may be called from several
+		// threads at once.
+		void							set_layout_threads(int count);
+		// null when layout runs on the calling thread only
+		task_pool*						layout_pool() const { return m_layout_pool.get(); }
+
+		// Creates an element in the document's element arena. The document is passed
+		// to the element's constructor after args.
+		template<class T, class... Args>
+		std::shared_ptr<T>				make_element(Args&&... args)
+		{
+			return std::allocate_shared<T>(arena_allocator<T>(m_elements_arena), std::forward<Args>(args)..., shared_from_this());
+		}
 
 		void                            append_children_from_string(element& parent, const tchar_t* str);
 		void                            append_children_from_utf8(element& parent, const char* str);
 
 		static litehtml::document::ptr createFromString(const tchar_t* str, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles = 0);
 		static litehtml::document::ptr createFromUTF8(const char* str, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles = 0);
+		// UTF-8 input of the given length; the data does not have to be NUL-terminated
+		// and is only read while the document is created.
+		static litehtml::document::ptr createFromBuffer(const char* data, size_t length, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles = 0);
+		// Maps the UTF-8 file read-only and parses it in place. Returns null if the file can't be mapped.
+		static litehtml::document::ptr createFromFile(const char* path, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles = 0);
+
+		// Asynchronous versions: all linked and @import-ed stylesheets are requested with
+		// document_container::import_css_async at once, on_ready is called (from the thread that
+		// delivered the last stylesheet) after they are loaded and the styles are applied.
+		// user_styles must stay valid until on_ready is called.
+		static void createFromStringAsync(const tchar_t* str, litehtml::document_container* objPainter, litehtml::context* ctx, const ready_callback& on_ready, litehtml::css* user_styles = 0);
+		static void createFromUTF8Async(const char* str, litehtml::document_container* objPainter, litehtml::context* ctx, const ready_callback& on_ready, litehtml::css* user_styles = 0);
 	
 	private:
 		litehtml::uint_ptr	add_font(const tchar_t* name, int size, const tchar_t* weight, const tchar_t* style, const tchar_t* decoration, font_metrics* fm);
 
+		element::ptr create_tag(const tchar_t* tag_name, const string_map& attributes);
 		void create_node(void* gnode, elements_vector& elements, bool parseTextNode);
+		void create_elements(const char* str, size_t length);
+		void apply_styles(litehtml::css* user_styles);
+		void request_linked_css(const element::ptr& el);
+		void request_css(const tstring& url, const tstring& baseurl);
+		void on_css_loaded(const tstring& url, const tstring& baseurl, const tstring& text, const tstring& css_baseurl);
+		void release_pending_import();
 		bool update_media_lists(const media_features& features);
 		void fix_tables_layout();
 		void fix_table_children(element::ptr& el_ptr, style_display disp, const tchar_t* disp_str);
@@ -122,6 +238,10 @@ namespace litehtml
 	{
 		m_tabular_elements.push_back(el);
 	}
+	inline void document::add_image(const std::shared_ptr<el_image>& el)
+	{
+		m_images.push_back(el);
+	}
 	inline bool document::match_lang(const tstring & lang)
 	{
 		return lang == m_lang || lang == m_culture;
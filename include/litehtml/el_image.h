@@ -9,6 +9,8 @@ namespace litehtml
 	class el_image : public html_tag
 	{
 		tstring	m_src;
+		size	m_layout_image_size;	// the image size the last layout was done with
+		bool	m_rendered;
 	public:
 		el_image(const std::shared_ptr<litehtml::document>& doc);
 		virtual ~el_image(void);
@@ -20,6 +22,10 @@ namespace litehtml
 		virtual void	parse_styles(bool is_reparse = false) override;
 		virtual void	draw(uint_ptr hdc, int x, int y, const position* clip) override;
 		virtual void	get_content_size(size& sz, int max_width) override;
+
+		// Returns true and marks the element for layout if the container reports
+		// another size for the image than the last layout used
+		bool			update_image_size();
 	private:
 		int calc_max_height(int image_height);
 	};
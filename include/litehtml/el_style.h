@@ -14,6 +14,7 @@ namespace litehtml
 
 		virtual void			parse_attributes() override;
 		virtual bool			appendChild(const ptr &el) override;
+		virtual void			get_text(tstring& text) override;
 		virtual const tchar_t*	get_tagName() const override;
 	};
 }
@@ -0,0 +1,98 @@
+#ifndef LH_EL_TEXT_RUN_H
+#define LH_EL_TEXT_RUN_H
+
+#include "html_tag.h"
+#include "el_text.h"
+
+namespace litehtml
+{
+	class el_text_run;
+	class line_box;
+
+	// Consecutive words of a text run placed into the same line box
+	class el_text_fragment : public el_text
+	{
+		el_text_run*	m_run;
+		int				m_first_word;
+		int				m_last_word;
+		bool			m_placed;
+		white_space		m_white_space;	// of the run when the fragment was laid out
+	public:
+		el_text_fragment(el_text_run* run, int word, const std::shared_ptr<litehtml::document>& doc);
+		virtual ~el_text_fragment();
+
+		int							first_word() const	{ return m_first_word;	}
+		int							last_word() const	{ return m_last_word;	}
+		void						set_placed()		{ m_placed = true;		}
+		line_box*					get_line_box() const;
+		void						extend(int last_word, int width);
+
+		virtual bool				is_white_space() const override;
+		virtual bool				is_break() const override;
+		virtual bool				is_text_run() const override;
+		virtual white_space			get_white_space() const override;
+		virtual int					get_inline_shift_left() override;
+		virtual int					get_inline_shift_right() override;
+		virtual int					render_inline(const ptr &container, int max_width) override;
+		virtual void				draw(uint_ptr hdc, int x, int y, const position* clip) override;
+	};
+
+	// Text node kept as one string with word boundaries. Layout flows the words
+	// into line boxes as el_text_fragment items instead of using an element per word.
+	class el_text_run : public el_text
+	{
+		friend class el_text_fragment;
+	public:
+		struct word
+		{
+			typedef std::vector<word>	vector;
+
+			unsigned int	offset;				// in m_text
+			unsigned int	length;
+			unsigned int	transformed_offset;	// in m_transformed_text, for text-transform
+			unsigned int	transformed_length;
+			int				width;
+			bool			is_space;
+			bool			skip;				// collapsed during the last layout
+		};
+		typedef std::vector<std::shared_ptr<el_text_fragment>>	fragments_vector;
+	private:
+		word::vector		m_words;
+		fragments_vector	m_fragments;
+		int					m_first_text_word;
+		int					m_last_text_word;
+		// m_prefix_widths[i] is the width of the words before i, collapsed spaces
+		// not counted, and m_breaks holds the forced line breaks, both for the
+		// white-space value in m_prefix_ws
+		int_vector			m_prefix_widths;
+		int_vector			m_breaks;
+		white_space			m_prefix_ws;
+	public:
+		el_text_run(const char* utf8_text, const std::shared_ptr<litehtml::document>& doc);
+		virtual ~el_text_run();
+
+		const word::vector&			get_words() const		{ return m_words;		}
+		const fragments_vector&		get_fragments() const	{ return m_fragments;	}
+
+		virtual bool				is_white_space() const override;
+		virtual bool				is_text_run() const override;
+		virtual int					render_inline(const ptr &container, int max_width) override;
+		virtual void				parse_styles(bool is_reparse) override;
+		virtual void				draw(uint_ptr hdc, int x, int y, const position* clip) override;
+		virtual void				calc_document_size(litehtml::size& sz, int x = 0, int y = 0) override;
+		virtual void				get_redraw_box(litehtml::position& pos, int x = 0, int y = 0) override;
+
+	private:
+		void						add_word(size_t offset, size_t length, bool is_space);
+		void						get_word_text(const word& wrd, white_space ws, tstring& text) const;
+		bool						is_white_space_word(const word& wrd, white_space ws) const;
+		bool						is_break_word(const word& wrd, white_space ws) const;
+		bool						is_collapsed_word(int i, white_space ws) const;
+		void						calc_prefix_widths(white_space ws);
+		int							fit_words(int start, int first, int last, int room) const;
+		int							place_words(const element::ptr& container, int first, int last, int max_width, size_t insert_at);
+		size_t						remove_fragment(const el_text_fragment* fragment);
+	};
+}
+
+#endif  // LH_EL_TEXT_RUN_H
@@ -30,6 +30,9 @@ namespace litehtml
 		margins						m_padding;
 		margins						m_borders;
 		bool						m_skip;
+		bool						m_layout_pending;
+		int							m_layout_dirty;
+		unsigned int				m_layout_dirty_generation;
 		
 		virtual void select_all(const css_selector& selector, elements_vector& res);
 	public:
@@ -86,9 +89,14 @@ namespace litehtml
 		void						parent(element::ptr par);
 		bool						is_visible() const;
 		int							calc_width(int defVal) const;
-		int							get_inline_shift_left();
-		int							get_inline_shift_right();
 		void						apply_relative_shift(int parent_width);
+		// Marks the element for layout and its ancestors as having a dirty descendant.
+		// Must not be called while the document is being rendered.
+		void						invalidate_layout();
+		bool						is_layout_dirty() const		{ return m_layout_dirty != 0; }
+		// below the point where document::render_partial() stopped: not laid out and not drawn
+		bool						is_layout_pending() const	{ return m_layout_pending; }
+		void						set_layout_pending(bool val)	{ m_layout_pending = val; }
 
 		std::shared_ptr<document>	get_document() const;
 
@@ -99,6 +107,12 @@ namespace litehtml
 		virtual element::ptr		select_one(const css_selector& selector);
 
 		virtual int					render(int x, int y, int max_width, bool second_pass = false);
+		// Returns what render(0, 0, max_width) returns. The width may come from an earlier
+		// layout with the same constraints, then the element keeps the boxes it has.
+		virtual int					measure(int max_width);
+		// Min-content width (measured at 1px) and the width of the content laid out
+		// at max_width, as used for table cells; the element keeps the boxes it has.
+		virtual void				get_intrinsic_widths(int max_width, int& min_width, int& max_content_width);
 		virtual int					render_inline(const ptr &container, int max_width);
 		virtual int					place_element(const ptr &el, int max_width);
 		virtual void				calc_outlines( int parent_width );
@@ -134,9 +148,13 @@ namespace litehtml
 		virtual const tchar_t*		get_attr(const tchar_t* name, const tchar_t* def = 0) const;
 		virtual void				apply_stylesheet(const litehtml::css& stylesheet);
 		virtual void				refresh_styles();
+		virtual void				apply_appended_stylesheet(const litehtml::css& stylesheet, const litehtml::css& master, const litehtml::css& author, elements_vector& changed);
 		virtual bool				is_white_space() const;
 		virtual bool				is_body() const;
 		virtual bool				is_break() const;
+		virtual bool				is_text_run() const;
+		virtual int					get_inline_shift_left();
+		virtual int					get_inline_shift_right();
 		virtual int					get_base_line();
 		virtual bool				on_mouse_over();
 		virtual bool				on_mouse_leave();
@@ -176,6 +194,10 @@ namespace litehtml
 		virtual void				get_content_size(size& sz, int max_width);
 		virtual void				init();
 		virtual bool				is_floats_holder() const;
+		virtual bool				have_floats() const;
+		// True if the width render() returns for the subtree may change with max_width
+		// while the content still fits: percentages, auto margins and floats
+		virtual bool				is_width_dependent() const;
 		virtual int					get_floats_height(element_float el_float = float_none) const;
 		virtual int					get_left_floats_height() const;
 		virtual int					get_right_floats_height() const;
@@ -387,7 +409,7 @@ namespace litehtml
 
 	inline bool litehtml::element::is_visible() const
 	{
-		return !(m_skip || get_display() == display_none || get_visibility() != visibility_visible);
+		return !(m_skip || m_layout_pending || get_display() == display_none || get_visibility() != visibility_visible);
 	}
 
 	inline position& litehtml::element::get_position()
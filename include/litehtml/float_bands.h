@@ -0,0 +1,47 @@
+#ifndef LH_FLOAT_BANDS_H
+#define LH_FLOAT_BANDS_H
+
+#include <vector>
+
+namespace litehtml
+{
+	// The space the floats of a floats holder take, split into horizontal bands
+	// where the line left and right stay the same. Every float top and bottom
+	// starts a band, so finding the band at y is a binary search.
+	class float_bands
+	{
+		struct band
+		{
+			int		top;		// the band ends where the next one begins
+			int		left;		// the right edge of the left floats, 0 if there are none
+			int		right;		// the left edge of the right floats
+			bool	has_right;
+		};
+
+		std::vector<band>	m_bands;	// sorted by top, the last band is always empty
+		bool				m_valid;
+	public:
+		float_bands() : m_valid(true) {}
+
+		bool	is_valid() const	{ return m_valid;	}
+		// the floats moved, the bands have to be built again
+		void	invalidate()		{ m_valid = false;	}
+		void	clear();
+
+		void	add_left(int top, int bottom, int right);
+		void	add_right(int top, int bottom, int left);
+
+		int		line_left(int y) const;
+		int		line_right(int y, int def_right) const;
+		// The first float top or bottom at or below top where a line of the given
+		// width fits, the lowest one if there is no such place, or top if there
+		// are no floats below it.
+		int		next_line_top(int top, int width, int def_right) const;
+
+	private:
+		int		find(int y) const;
+		int		split(int y);
+	};
+}
+
+#endif  // LH_FLOAT_BANDS_H
@@ -9,6 +9,7 @@
 #include <cstring>
 #include <algorithm>
 #include <sstream>
+#include <functional>
 #include "os_types.h"
 #include "types.h"
 #include "background.h"
@@ -30,6 +31,9 @@ namespace litehtml
 		uint_ptr		font;
 	};
 
+	// called by document_container::import_css_async when the stylesheet text is available
+	typedef std::function<void(const litehtml::tstring& text, const litehtml::tstring& baseurl)> import_css_callback;
+
 	// call back interface to draw text, images and other elements
 	class document_container
 	{
@@ -60,10 +64,24 @@ namespace litehtml
 		virtual std::shared_ptr<litehtml::element>	create_element(const litehtml::tchar_t *tag_name,
 																	 const litehtml::string_map &attributes,
 																	 const std::shared_ptr<litehtml::document> &doc) = 0;
+		// false if create_element always returns null; the parser then does not collect
+		// the attributes of every element for it
+		virtual bool				creates_elements() const { return true; }
 
 		virtual void				get_media_features(litehtml::media_features& media) const = 0;
 		virtual void				get_language(litehtml::tstring& language, litehtml::tstring & culture) const = 0;
 		virtual litehtml::tstring	resolve_color(const litehtml::tstring& color) const  { return litehtml::tstring(); }
+
+		// Starts loading of the stylesheet and calls on_loaded when it is ready. Can be called for several
+		// stylesheets before any of them completes; on_loaded may be called from any thread.
+		// The default implementation falls back to the synchronous import_css.
+		virtual void				import_css_async(const litehtml::tstring& url, const litehtml::tstring& baseurl, const litehtml::import_css_callback& on_loaded)
+		{
+			litehtml::tstring text;
+			litehtml::tstring css_baseurl = baseurl;
+			import_css(text, url, css_baseurl);
+			on_loaded(text, css_baseurl);
+		}
 	};
 
 	void trim(tstring &s);
@@ -10,6 +10,8 @@
 #include "stylesheet.h"
 #include "box.h"
 #include "table.h"
+#include "float_bands.h"
+#include "arena.h"
 
 namespace litehtml
 {
@@ -30,6 +32,79 @@ namespace litehtml
 		}
 	};
 
+	// Constraints html_tag::render lays the element out with
+	struct layout_key
+	{
+		int		max_width;
+		bool	second_pass;
+		int		parent_height;		// height percentages are resolved against
+		bool	movable;			// the layout does not depend on the element's position
+		bool	fixed_width;		// nor on max_width
+		size	viewport;			// vw, vh, vmin and vmax are resolved against, 0 x 0 if the document has none
+
+		layout_key() : max_width(0), second_pass(false), parent_height(0), movable(false), fixed_width(false)
+		{
+		}
+
+		bool matches(const layout_key& val) const
+		{
+			return (max_width == val.max_width || (fixed_width && val.fixed_width)) && same_constraints(val);
+		}
+
+		// everything but the width matches
+		bool same_constraints(const layout_key& val) const
+		{
+			return movable && val.movable && second_pass == val.second_pass && parent_height == val.parent_height &&
+				viewport.width == val.viewport.width && viewport.height == val.viewport.height;
+		}
+	};
+
+	// Outcome of the last html_tag::render, the one the element's boxes are from.
+	// The position is kept relative to the x, y the element was rendered at.
+	struct layout_result
+	{
+		bool		valid;
+		layout_key	key;
+		int			ret_width;
+		int			dx;
+		int			dy;
+		int			width;
+		int			height;
+		margins		el_margins;
+		margins		el_padding;
+		margins		el_borders;
+
+		layout_result() : valid(false), ret_width(0), dx(0), dy(0), width(0), height(0)
+		{
+		}
+	};
+
+	// Width returned by html_tag::render for a key, kept while the element is clean
+	struct layout_width
+	{
+		unsigned int	generation;		// html_tag::m_layout_cache_generation
+		layout_key		key;
+		int				ret_width;
+
+		layout_width() : generation(0), ret_width(0)
+		{
+		}
+	};
+
+	// Element attribute; the name is lowercase and comes from document::attribute_name()
+	struct html_attribute
+	{
+		typedef std::vector<html_attribute>	vector;
+
+		const tchar_t*	name;
+		tstring			value;
+		bool			pooled;		// the name comes from intern_string()
+
+		html_attribute(const tchar_t* n, const tchar_t* v, bool is_pooled) : name(n), value(v), pooled(is_pooled)
+		{
+		}
+	};
+
 	class html_tag : public element
 	{
 		friend class elements_iterator;
@@ -41,10 +116,12 @@ namespace litehtml
 		typedef std::shared_ptr<litehtml::html_tag>	ptr;
 	protected:
 		box::vector				m_boxes;
+		line_items				m_line_items;
+		arena					m_boxes_arena;
 		string_vector			m_class_values;
 		tstring					m_tag;
 		litehtml::style			m_style;
-		string_map				m_attrs;
+		html_attribute::vector	m_attrs;
 		vertical_align			m_vertical_align;
 		text_align				m_text_align;
 		style_display			m_display;
@@ -84,8 +161,22 @@ namespace litehtml
 		int						m_z_index;
 		box_sizing				m_box_sizing;
 
-		int_int_cache			m_cahe_line_left;
-		int_int_cache			m_cahe_line_right;
+		float_bands				m_float_bands;
+
+		layout_result			m_last_layout;
+		layout_width			m_layout_widths[3];
+		int						m_layout_widths_next;
+		layout_width			m_min_content_width;
+		layout_width			m_max_content_width;
+		unsigned int			m_layout_cache_generation;
+		bool					m_layout_stopped;		// render_box() stopped before the end of a partial layout
+		bool					m_layout_resumed;		// render_box() goes on from where it stopped
+		int						m_resume_child;			// the child of the last block box when it stopped, -1 if it can't go on
+		int						m_resume_ret_width;
+		layout_key				m_resume_key;
+		litehtml::size			m_children_size;		// the document size of the children a resumed layout keeps,
+		size_t					m_children_size_count;	// from the content origin, and how many children they are
+		int						m_vertical_align_shift;
 
 		// data for table rendering
 		std::unique_ptr<table_grid>	m_grid;
@@ -104,6 +195,8 @@ namespace litehtml
 		/* render functions */
 
 		virtual int					render(int x, int y, int max_width, bool second_pass = false) override;
+		virtual int					measure(int max_width) override;
+		virtual void				get_intrinsic_widths(int max_width, int& min_width, int& max_content_width) override;
 
 		virtual int					render_inline(const element::ptr &container, int max_width) override;
 		virtual int					place_element(const element::ptr &el, int max_width) override;
@@ -114,6 +207,7 @@ namespace litehtml
 
 		int							get_cleared_top(const element::ptr &el, int line_top) const;
 		int							finish_last_box(bool end_of_render = false);
+		void						pop_box();
 
 		virtual bool				appendChild(const element::ptr &el) override;
 		virtual bool				removeChild(const element::ptr &el) override;
@@ -138,9 +232,12 @@ namespace litehtml
 		virtual overflow			get_overflow() const override;
 
 		virtual void				set_attr(const tchar_t* name, const tchar_t* val) override;
-		virtual const tchar_t*		get_attr(const tchar_t* name, const tchar_t* def = 0) const override;
+		virtual const tchar_t*		get_attr(const tchar_t* name, const tchar_t* def = 0) const override;
+		// get_attr() for a name from intern_string(), compares pooled names by address
+		const tchar_t*				get_pooled_attr(const tchar_t* pooled_name) const;
 		virtual void				apply_stylesheet(const litehtml::css& stylesheet) override;
 		virtual void				refresh_styles() override;
+		virtual void				apply_appended_stylesheet(const litehtml::css& stylesheet, const litehtml::css& master, const litehtml::css& author, elements_vector& changed) override;
 
 		virtual bool				is_white_space() const override;
 		virtual bool				is_body() const override;
@@ -195,6 +292,8 @@ namespace litehtml
 		virtual void				init() override;
 		virtual void				get_inline_boxes(position::vector& boxes) override;
 		virtual bool				is_floats_holder() const override;
+		virtual bool				have_floats() const override;
+		virtual bool				is_width_dependent() const override;
 		virtual int					get_floats_height(element_float el_float = float_none) const override;
 		virtual int					get_left_floats_height() const override;
 		virtual int					get_right_floats_height() const override;
@@ -226,6 +325,14 @@ namespace litehtml
 		int							render_box(int x, int y, int max_width, bool second_pass = false);
 		int							render_table(int x, int y, int max_width, bool second_pass = false);
 		int							fix_line_width(int max_width, element_float flt);
+		layout_key					get_layout_key(int max_width, bool second_pass) const;
+		bool						is_fixed_width() const;
+		bool						is_in_main_flow() const;
+		void						stop_layout(size_t next_child, int ret_width);
+		bool						has_relative_widths() const;
+		void						add_layout_width(const layout_key& key, int ret_width);
+		void						restore_last_layout(int x, int y);
+		const float_bands&			get_float_bands();
 		void						parse_background();
 		void						init_background_paint( position pos, background_paint &bg_paint, const background* bg );
 		void						draw_list_marker( uint_ptr hdc, const position &pos );
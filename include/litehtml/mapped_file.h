@@ -0,0 +1,31 @@
+#ifndef LH_MAPPED_FILE_H
+#define LH_MAPPED_FILE_H
+
+#include <cstddef>
+
+namespace litehtml
+{
+	// Read-only memory mapping of a whole file. The data is not NUL-terminated.
+	class mapped_file
+	{
+		const char*	m_data;
+		size_t		m_size;
+		void*		m_file;		// file and mapping handles on Windows
+		void*		m_mapping;
+	public:
+		mapped_file();
+		~mapped_file();
+
+		bool		open(const char* path);
+		void		close();
+
+		const char*	data() const	{ return m_data; }
+		size_t		size() const	{ return m_size; }
+
+	private:
+		mapped_file(const mapped_file&);
+		mapped_file& operator=(const mapped_file&);
+	};
+}
+
+#endif  // LH_MAPPED_FILE_H
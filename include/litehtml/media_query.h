@@ -22,6 +22,35 @@ namespace litehtml
 		bool check(const media_features& features) const;
 	};
 
+	// Deduplicated thresholds of the media query expressions. The media features
+	// with the same signature give the same result for every added expression,
+	// so the queries have to be checked again only when the signature changes.
+	class media_breakpoints
+	{
+	public:
+		enum dimension
+		{
+			dimension_width,
+			dimension_height,
+			dimension_device_width,
+			dimension_device_height,
+			dimension_aspect_ratio,
+			dimension_device_aspect_ratio,
+			dimension_color,
+			dimension_color_index,
+			dimension_monochrome,
+			dimension_resolution,
+			dimensions_count
+		};
+	private:
+		int_vector	m_thresholds[dimensions_count];
+	public:
+		void add(const media_query_expression& expr);
+		void get_signature(const media_features& features, int_vector& signature) const;
+	private:
+		void add_threshold(dimension dim, int val);
+	};
+
 	class media_query
 	{
 	public:
@@ -37,6 +66,7 @@ namespace litehtml
 
 		static media_query::ptr create_from_string(const tstring& str, const std::shared_ptr<document>& doc);
 		bool check(const media_features& features) const;
+		void add_breakpoints(media_breakpoints& breakpoints) const;
 	};
 
 	class media_query_list
@@ -54,6 +84,7 @@ namespace litehtml
 		static media_query_list::ptr create_from_string(const tstring& str, const std::shared_ptr<document>& doc);
 		bool is_used() const;
 		bool apply_media_features(const media_features& features);	// returns true if the m_is_used changed
+		void add_breakpoints(media_breakpoints& breakpoints) const;
 	};
 
 	inline media_query_list::media_query_list(const media_query_list& val)
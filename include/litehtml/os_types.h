@@ -25,6 +25,8 @@ namespace litehtml
 	#define t_strstr			wcsstr
 	#define t_tolower			towlower
 	#define t_isdigit			iswdigit
+	#define t_isspace			iswspace
+	#define t_isalpha			iswalpha
 	#define t_to_string(val)	std::to_wstring(val)
 
 #else
@@ -47,6 +49,8 @@ namespace litehtml
 	#define t_strstr			strstr
 	#define t_tolower			tolower
 	#define t_isdigit			isdigit
+	#define t_isspace			isspace
+	#define t_isalpha			isalpha
 	#define t_to_string(val)	std::to_string(val)
 
 #endif
@@ -81,6 +85,8 @@ namespace litehtml
 	#define t_strstr			strstr
 	#define t_tolower			tolower
 	#define t_isdigit			isdigit
+	#define t_isspace			isspace
+	#define t_isalpha			isalpha
 	#define t_to_string(val)	std::to_string(val)
 
 #endif
@@ -0,0 +1,14 @@
+#ifndef LH_STRING_POOL_H
+#define LH_STRING_POOL_H
+
+namespace litehtml
+{
+	// Returns the pooled copy of str. Equal strings give the same pointer, so pooled
+	// strings can be compared by address. Pooled strings live until the process exits,
+	// so only names from selectors are pooled, not names found in documents.
+	const tchar_t* intern_string(const tchar_t* str);
+	// the pooled copy of str, or null if it was not pooled
+	const tchar_t* find_interned_string(const tchar_t* str);
+}
+
+#endif  // LH_STRING_POOL_H
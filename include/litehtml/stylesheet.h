@@ -34,12 +34,17 @@ namespace litehtml
 
 		void	parse_stylesheet(const tchar_t* str, const tchar_t* baseurl, const std::shared_ptr <document>& doc, const media_query_list::ptr& media);
 		void	sort_selectors();
+		void	merge(const css& stylesheet);
+		bool	contains(const css_selector::ptr& selector) const;
 		static void	parse_css_url(const tstring& str, tstring& url);
+		static void	collect_imports(const tchar_t* str, string_vector& urls);
 
 	private:
 		void	parse_atrule(const tstring& text, const tchar_t* baseurl, const std::shared_ptr<document>& doc, const media_query_list::ptr& media);
 		void	add_selector(css_selector::ptr selector);
 		bool	parse_selectors(const tstring& txt, const litehtml::style::ptr& styles, const media_query_list::ptr& media);
+		static bool	parse_import(const tstring& text, tstring& url, tstring& media_str);
+		static void	remove_comments(tstring& text);
 
 	};
 
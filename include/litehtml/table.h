@@ -76,6 +76,7 @@ namespace litehtml
 		int			max_width;
 		int			width;
 		css_length	css_width;
+		css_length	css_calc_width;		// a calc() width, css_width holds it in pixels for the current layout
 		int			border_left;
 		int			border_right;
 		int			left;
@@ -115,6 +116,7 @@ namespace litehtml
 			min_width		= val.min_width;
 			width			= val.width;
 			css_width		= val.css_width;
+			css_calc_width	= val.css_calc_width;
 		}
 	};
 
@@ -220,6 +222,7 @@ namespace litehtml
 		void			add_cell(element::ptr& el);
 		bool			is_rowspanned(int r, int c);
 		void			finish();
+		void			convert_calc_widths(int block_width);
 		table_cell*		cell(int t_col, int t_row);
 		table_column&	column(int c)	{ return m_columns[c];	}
 		table_row&		row(int r)		{ return m_rows[r];		}
@@ -0,0 +1,51 @@
+#ifndef LH_TASK_POOL_H
+#define LH_TASK_POOL_H
+
+#include <vector>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace litehtml
+{
+	// Threads running the iterations of parallel loops. Idle threads take the
+	// next iteration of any loop still open, and the thread that started a loop
+	// runs its iterations too while it waits, so a loop body may start loops of
+	// its own.
+	class task_pool
+	{
+		struct loop
+		{
+			const std::function<void(int)>*	fn;
+			int								count;
+			std::atomic<int>				next;		// the next iteration to take
+			std::atomic<int>				done;		// iterations finished
+			int								workers;	// pool threads inside work(), guarded by m_mutex
+		};
+
+		std::vector<std::thread>	m_threads;
+		std::list<loop*>			m_loops;		// loops with iterations left to take
+		std::mutex					m_mutex;
+		std::condition_variable		m_wake;			// a loop was started or the pool stops
+		std::condition_variable		m_finished;		// a loop was finished or a thread left it
+		bool						m_stop;
+	public:
+		// threads: the number of threads besides the ones calling run()
+		explicit task_pool(int threads);
+		~task_pool();
+
+		int		threads_count() const	{ return (int) m_threads.size(); }
+		// Calls fn(0) ... fn(count - 1), in any order and on any of the threads,
+		// and returns after all of them returned.
+		void	run(int count, const std::function<void(int)>& fn);
+
+	private:
+		void	thread_proc();
+		void	work(loop& lp);
+	};
+}
+
+#endif  // LH_TASK_POOL_H
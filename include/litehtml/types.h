@@ -558,33 +558,6 @@ namespace litehtml
 		}
 	};
 
-	struct int_int_cache
-	{
-		int		hash;
-		int		val;
-		bool	is_valid;
-		bool	is_default;
-
-		int_int_cache()
-		{
-			hash		= 0;
-			val			= 0;
-			is_valid	= false;
-			is_default	= false;
-		}
-		void invalidate()
-		{
-			is_valid	= false;
-			is_default	= false;
-		}
-		void set_value(int vHash, int vVal)
-		{
-			hash		= vHash;
-			val			= vVal;
-			is_valid	= true;
-		}
-	};
-
 	enum select_result
 	{
 		select_no_match				= 0x00,
@@ -730,6 +703,13 @@ namespace litehtml
 		render_fixed_only,
 	};
 
+	// element::m_layout_dirty bits
+	enum layout_dirty_flags
+	{
+		layout_dirty_self		= 0x01,	// the element's own styles or children changed
+		layout_dirty_children	= 0x02,	// some descendant has to be laid out again
+	};
+
 	// List of the Void Elements (can't have any contents)
 	const litehtml::tchar_t* const void_elements = _t("area;base;br;col;command;embed;hr;img;input;keygen;link;meta;param;source;track;wbr");
 }
@@ -42,6 +42,56 @@ namespace litehtml
 		}
 	};
 
+	// Splits NUL-terminated UTF-8 text into words, single whitespace characters and
+	// single CJK ideographs without decoding it. on_piece(const char* piece, size_t length,
+	// bool is_space) is called for every piece in order; pieces point into str.
+	template<class F> void split_utf8_text(const char* str, F on_piece)
+	{
+		const char* word = str;
+		const char* p = str;
+		while (*p)
+		{
+			byte c = (byte) *p;
+			if (c < 0x80)
+			{
+				if (c <= ' ' && (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'))
+				{
+					if (p != word)
+					{
+						on_piece(word, p - word, false);
+					}
+					on_piece(p, 1, true);
+					word = p + 1;
+				}
+				p++;
+				continue;
+			}
+
+			const char* ch = p;
+			size_t len = c >= 0xF0 ? 4 : (c >= 0xE0 ? 3 : (c >= 0xC0 ? 2 : 1));
+			for (p++; --len && (((byte) *p) & 0xC0) == 0x80; p++);
+
+			// CJK character range U+4E00..U+9FCC is encoded as E4 B8 80 .. E9 BE 8C
+			if (p - ch == 3 && c >= 0xE4 && c <= 0xE9)
+			{
+				ucode_t code = ((c & 0x0F) << 12) | ((((byte) ch[1]) & 0x3F) << 6) | (((byte) ch[2]) & 0x3F);
+				if (code >= 0x4E00 && code <= 0x9FCC)
+				{
+					if (ch != word)
+					{
+						on_piece(word, ch - word, false);
+					}
+					on_piece(ch, 3, false);
+					word = p;
+				}
+			}
+		}
+		if (p != word)
+		{
+			on_piece(word, p - word, false);
+		}
+	}
+
 #ifdef LITEHTML_UTF8
 #define litehtml_from_utf8(str)		str
 #define litehtml_to_utf8(str)		str
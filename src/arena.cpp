@@ -0,0 +1,113 @@
+#include "html.h"
+#include "arena.h"
+
+namespace
+{
+	// every allocation is aligned as malloc would align it
+	const size_t arena_alignment = alignof(std::max_align_t);
+
+	inline size_t arena_align(size_t size)
+	{
+		return (size + arena_alignment - 1) & ~(arena_alignment - 1);
+	}
+}
+
+litehtml::arena::arena(size_t block_size, size_t max_block_size)
+{
+	m_blocks		= 0;
+	m_current		= 0;
+	m_block_size	= block_size ? block_size : 1;
+	m_max_block_size	= max_block_size;
+	m_used			= 0;
+	m_high_water	= 0;
+}
+
+litehtml::arena::~arena()
+{
+	clear();
+}
+
+void* litehtml::arena::allocate(size_t size)
+{
+	// the block header is followed by its data
+	const size_t header_size = arena_align(sizeof(block));
+
+	size = arena_align(size ? size : 1);
+	block* blk = m_current;
+	if (!blk || blk->size - blk->used < size)
+	{
+		if (blk && blk->next && blk->next->size >= size)
+		{
+			// the blocks after the current one were kept by rewind()
+			blk			= blk->next;
+			blk->used	= 0;
+			m_current	= blk;
+		}
+		else
+		{
+			// oversized requests get a block of their own
+			size_t data_size = size > m_block_size ? size : m_block_size;
+			blk = (block*) malloc(header_size + data_size);
+			if (!blk)
+			{
+				return 0;
+			}
+			blk->size	= data_size;
+			blk->used	= 0;
+			if (!m_current)
+			{
+				blk->next	= 0;
+				m_blocks	= blk;
+				m_current	= blk;
+			}
+			else if (data_size > m_block_size)
+			{
+				// keep filling the current block; the new one goes first, where
+				// rewind() starts taking memory again
+				blk->next	= m_blocks;
+				m_blocks	= blk;
+			}
+			else
+			{
+				blk->next		= m_current->next;
+				m_current->next	= blk;
+				m_current		= blk;
+			}
+			if (data_size == m_block_size && m_block_size < m_max_block_size)
+			{
+				m_block_size = std::min(m_block_size * 2, m_max_block_size);
+			}
+		}
+	}
+
+	void* ret = (char*) blk + header_size + blk->used;
+	blk->used	+= size;
+	m_used		+= size;
+	if (m_used > m_high_water)
+	{
+		m_high_water = m_used;
+	}
+	return ret;
+}
+
+void litehtml::arena::clear()
+{
+	while (m_blocks)
+	{
+		block* next = m_blocks->next;
+		free(m_blocks);
+		m_blocks = next;
+	}
+	m_current	= 0;
+	m_used		= 0;
+}
+
+void litehtml::arena::rewind()
+{
+	m_current = m_blocks;
+	if (m_current)
+	{
+		m_current->used = 0;
+	}
+	m_used = 0;
+}
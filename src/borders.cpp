@@ -0,0 +1,19 @@
+#include "html.h"
+#include "borders.h"
+#include "document.h"
+
+litehtml::border_radiuses litehtml::css_border_radius::calc_percents(const document& doc, int font_size, int width, int height) const
+{
+	// cvt_units may store a conversion in the length, the radius itself stays as declared
+	css_border_radius radius = *this;
+	border_radiuses ret;
+	ret.bottom_left_x	= doc.cvt_units(radius.bottom_left_x, font_size, width);
+	ret.bottom_left_y	= doc.cvt_units(radius.bottom_left_y, font_size, height);
+	ret.top_left_x		= doc.cvt_units(radius.top_left_x, font_size, width);
+	ret.top_left_y		= doc.cvt_units(radius.top_left_y, font_size, height);
+	ret.top_right_x		= doc.cvt_units(radius.top_right_x, font_size, width);
+	ret.top_right_y		= doc.cvt_units(radius.top_right_y, font_size, height);
+	ret.bottom_right_x	= doc.cvt_units(radius.bottom_right_x, font_size, width);
+	ret.bottom_right_y	= doc.cvt_units(radius.bottom_right_y, font_size, height);
+	return ret;
+}
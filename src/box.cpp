@@ -20,7 +20,7 @@ int litehtml::block_box::width()
 
 void litehtml::block_box::add_element(const element::ptr &el)
 {
-	m_element = el;
+	m_element = el.get();
 	el->m_box = this;
 }
 
@@ -59,7 +59,7 @@ int litehtml::block_box::baseline()
 
 void litehtml::block_box::get_elements( elements_vector& els )
 {
-	els.push_back(m_element);
+	els.push_back(m_element ? m_element->shared_from_this() : element::ptr());
 }
 
 int litehtml::block_box::top_margin()
@@ -116,7 +116,7 @@ void litehtml::line_box::add_element(const element::ptr &el)
 	el->m_skip	= false;
 	el->m_box	= 0;
 	bool add	= true;
-	if( (m_items.empty() && el->is_white_space()) || el->is_break() )
+	if( (!m_items_count && el->is_white_space()) || el->is_break() )
 	{
 		el->m_skip = true;
 	} else if(el->is_white_space())
@@ -131,7 +131,8 @@ void litehtml::line_box::add_element(const element::ptr &el)
 	if(add)
 	{
 		el->m_box = this;
-		m_items.push_back(el);
+		m_items.push_back(el.get());
+		m_items_count++;
 
 		if(!el->m_skip)
 		{
@@ -153,14 +154,15 @@ void litehtml::line_box::finish(bool last_box)
 		return;
 	}
 
-	for(auto i = m_items.rbegin(); i != m_items.rend(); i++)
+	for(size_t i = m_items_count; i > 0; i--)
 	{
-		if((*i)->is_white_space() || (*i)->is_break())
+		element* el = item(i - 1);
+		if(el->is_white_space() || el->is_break())
 		{
-			if(!(*i)->m_skip)
+			if(!el->m_skip)
 			{
-				(*i)->m_skip = true;
-				m_width -= (*i)->width();
+				el->m_skip = true;
+				m_width -= el->width();
 			}
 		} else
 		{
@@ -192,8 +194,9 @@ void litehtml::line_box::finish(bool last_box)
 
 	m_height = 0;
 	// find line box baseline and line-height
-	for(const auto& el : m_items)
+	for(size_t i = 0; i < m_items_count; i++)
 	{
+		element* el = item(i);
 		if(el->get_display() == display_inline_text)
 		{
 			font_metrics fm;
@@ -215,8 +218,9 @@ void litehtml::line_box::finish(bool last_box)
 	int y1	= 0;
 	int y2	= m_height;
 
-	for (const auto& el : m_items)
+	for(size_t i = 0; i < m_items_count; i++)
 	{
+		element* el = item(i);
 		if(el->get_display() == display_inline_text)
 		{
 			font_metrics fm;
@@ -254,8 +258,9 @@ void litehtml::line_box::finish(bool last_box)
 
 	css_offsets offsets;
 
-	for (const auto& el : m_items)
+	for(size_t i = 0; i < m_items_count; i++)
 	{
+		element* el = item(i);
 		el->m_pos.y -= y1;
 		el->m_pos.y += m_box_top;
 		if(el->get_display() != display_inline_text)
@@ -317,12 +322,33 @@ bool litehtml::line_box::can_hold(const element::ptr &el, white_space ws)
 	return true;
 }
 
+// Widens the last item of the line in place. The first item is never grown, so
+// new_width() can still move everything after it to the next line.
+bool litehtml::line_box::grow(const element::ptr &el, int width, white_space ws)
+{
+	if(m_items_count < 2 || item(m_items_count - 1) != el.get() || el->m_skip)
+	{
+		return false;
+	}
+
+	if(ws != white_space_nowrap && ws != white_space_pre)
+	{
+		if(m_box_left + m_width + width > m_box_right)
+		{
+			return false;
+		}
+	}
+
+	m_width += width;
+	return true;
+}
+
 bool litehtml::line_box::have_last_space()
 {
 	bool ret = false;
-	for (auto i = m_items.rbegin(); i != m_items.rend() && !ret; i++)
+	for(size_t i = m_items_count; i > 0 && !ret; i--)
 	{
-		if((*i)->is_white_space() || (*i)->is_break())
+		if(item(i - 1)->is_white_space() || item(i - 1)->is_break())
 		{
 			ret = true;
 		} else
@@ -335,10 +361,10 @@ bool litehtml::line_box::have_last_space()
 
 bool litehtml::line_box::is_empty()
 {
-	if(m_items.empty()) return true;
-	for (auto i = m_items.rbegin(); i != m_items.rend(); i++)
+	if(!m_items_count) return true;
+	for(size_t i = m_items_count; i > 0; i--)
 	{
-		if(!(*i)->m_skip || (*i)->is_break())
+		if(!item(i - 1)->m_skip || item(i - 1)->is_break())
 		{
 			return false;
 		}
@@ -353,7 +379,13 @@ int litehtml::line_box::baseline()
 
 void litehtml::line_box::get_elements( elements_vector& els )
 {
-	els.insert(els.begin(), m_items.begin(), m_items.end());
+	elements_vector items;
+	items.reserve(m_items_count);
+	for(size_t i = 0; i < m_items_count; i++)
+	{
+		items.push_back(item(i)->shared_from_this());
+	}
+	els.insert(els.begin(), items.begin(), items.end());
 }
 
 int litehtml::line_box::top_margin()
@@ -369,21 +401,21 @@ int litehtml::line_box::bottom_margin()
 void litehtml::line_box::y_shift( int shift )
 {
 	m_box_top += shift;
-	for (auto& el : m_items)
+	for(size_t i = 0; i < m_items_count; i++)
 	{
-		el->m_pos.y += shift;
+		item(i)->m_pos.y += shift;
 	}
 }
 
 bool litehtml::line_box::is_break_only()
 {
-	if(m_items.empty()) return true;
+	if(!m_items_count) return true;
 
-	if(m_items.front()->is_break())
+	if(item(0)->is_break())
 	{
-		for (auto& el : m_items)
+		for(size_t i = 0; i < m_items_count; i++)
 		{
-			if(!el->m_skip)
+			if(!item(i)->m_skip)
 			{
 				return false;
 			}
@@ -401,10 +433,10 @@ void litehtml::line_box::new_width( int left, int right, elements_vector& els )
 		m_box_left	= left;
 		m_box_right	= right;
 		m_width = 0;
-		auto remove_begin = m_items.end();
-		for (auto i = m_items.begin() + 1; i != m_items.end(); i++)
+		size_t remove_begin = m_items_count;
+		for(size_t i = 1; i < m_items_count; i++)
 		{
-			element::ptr el = (*i);
+			element* el = item(i);
 
 			if(!el->m_skip)
 			{
@@ -419,10 +451,17 @@ void litehtml::line_box::new_width( int left, int right, elements_vector& els )
 				}
 			}
 		}
-		if(remove_begin != m_items.end())
+		if(remove_begin != m_items_count)
 		{
-			els.insert(els.begin(), remove_begin, m_items.end());
-			m_items.erase(remove_begin, m_items.end());
+			// the line is the last one, its items end the array
+			elements_vector removed;
+			for(size_t i = remove_begin; i < m_items_count; i++)
+			{
+				removed.push_back(item(i)->shared_from_this());
+			}
+			els.insert(els.begin(), removed.begin(), removed.end());
+			m_items.resize(m_first_item + remove_begin);
+			m_items_count = remove_begin;
 
 			for(const auto& el : els)
 			{
@@ -1,13 +1,208 @@
 #include "html.h"
 #include "css_length.h"
 
+namespace
+{
+	// calc() value is a linear combination of the units, the number is css_units_none
+	typedef litehtml::css_calc_term::vector calc_value;
+
+	bool calc_parse_sum(const litehtml::tstring& str, size_t& pos, calc_value& res);
+
+	void calc_skip_spaces(const litehtml::tstring& str, size_t& pos)
+	{
+		while(pos < str.length() && t_isspace(str[pos]))
+		{
+			pos++;
+		}
+	}
+
+	void calc_add(calc_value& sum, const calc_value& val, float k)
+	{
+		for(const auto& term : val)
+		{
+			bool found = false;
+			for(auto& sum_term : sum)
+			{
+				if(sum_term.units == term.units)
+				{
+					sum_term.value += term.value * k;
+					found = true;
+					break;
+				}
+			}
+			if(!found)
+			{
+				litehtml::css_calc_term new_term;
+				new_term.value	= term.value * k;
+				new_term.units	= term.units;
+				sum.push_back(new_term);
+			}
+		}
+	}
+
+	bool calc_is_number(const calc_value& val, float& num)
+	{
+		num = 0;
+		for(const auto& term : val)
+		{
+			if(term.units != litehtml::css_units_none)
+			{
+				return false;
+			}
+			num += term.value;
+		}
+		return true;
+	}
+
+	bool calc_parse_factor(const litehtml::tstring& str, size_t& pos, calc_value& res)
+	{
+		calc_skip_spaces(str, pos);
+		if(pos >= str.length())
+		{
+			return false;
+		}
+		if(str[pos] == _t('(') || !str.compare(pos, 5, _t("calc(")))
+		{
+			pos = str.find(_t('('), pos) + 1;
+			if(!calc_parse_sum(str, pos, res))
+			{
+				return false;
+			}
+			calc_skip_spaces(str, pos);
+			if(pos >= str.length() || str[pos] != _t(')'))
+			{
+				return false;
+			}
+			pos++;
+			return true;
+		}
+		if(str[pos] == _t('-') && pos + 1 < str.length() && !t_isdigit(str[pos + 1]) && str[pos + 1] != _t('.'))
+		{
+			pos++;
+			calc_value val;
+			if(!calc_parse_factor(str, pos, val))
+			{
+				return false;
+			}
+			calc_add(res, val, -1);
+			return true;
+		}
+
+		const litehtml::tchar_t* start = str.c_str() + pos;
+		litehtml::tchar_t* end = nullptr;
+		float num = (float) t_strtod(start, &end);
+		if(end == start)
+		{
+			return false;
+		}
+		pos += end - start;
+
+		size_t unit_start = pos;
+		if(pos < str.length() && str[pos] == _t('%'))
+		{
+			pos++;
+		} else
+		{
+			while(pos < str.length() && t_isalpha(str[pos]))
+			{
+				pos++;
+			}
+		}
+		int units = litehtml::css_units_none;
+		if(pos != unit_start)
+		{
+			units = litehtml::value_index(str.substr(unit_start, pos - unit_start), css_units_strings, -1);
+			if(units < 0)
+			{
+				return false;
+			}
+		}
+		litehtml::css_calc_term term;
+		term.value	= num;
+		term.units	= (litehtml::css_units) units;
+		res.push_back(term);
+		return true;
+	}
+
+	bool calc_parse_product(const litehtml::tstring& str, size_t& pos, calc_value& res)
+	{
+		if(!calc_parse_factor(str, pos, res))
+		{
+			return false;
+		}
+		while(true)
+		{
+			calc_skip_spaces(str, pos);
+			if(pos >= str.length() || (str[pos] != _t('*') && str[pos] != _t('/')))
+			{
+				return true;
+			}
+			litehtml::tchar_t op = str[pos++];
+			calc_value val;
+			if(!calc_parse_factor(str, pos, val))
+			{
+				return false;
+			}
+			float num;
+			if(op == _t('/'))
+			{
+				if(!calc_is_number(val, num) || num == 0)
+				{
+					return false;
+				}
+				calc_value quot;
+				calc_add(quot, res, 1 / num);
+				res.swap(quot);
+			} else if(calc_is_number(val, num))
+			{
+				calc_value prod;
+				calc_add(prod, res, num);
+				res.swap(prod);
+			} else if(calc_is_number(res, num))
+			{
+				res.clear();
+				calc_add(res, val, num);
+			} else
+			{
+				// length * length
+				return false;
+			}
+		}
+	}
+
+	bool calc_parse_sum(const litehtml::tstring& str, size_t& pos, calc_value& res)
+	{
+		if(!calc_parse_product(str, pos, res))
+		{
+			return false;
+		}
+		while(true)
+		{
+			calc_skip_spaces(str, pos);
+			if(pos >= str.length() || (str[pos] != _t('+') && str[pos] != _t('-')))
+			{
+				return true;
+			}
+			float k = str[pos++] == _t('-') ? -1.0f : 1.0f;
+			calc_value val;
+			if(!calc_parse_product(str, pos, val))
+			{
+				return false;
+			}
+			calc_add(res, val, k);
+		}
+	}
+}
+
 void litehtml::css_length::fromString( const tstring& str, const tstring& predefs, int defValue )
 {
-	// TODO: Make support for calc
-	if(str.substr(0, 4) == _t("calc"))
+	if(str.substr(0, 5) == _t("calc("))
 	{
-		m_is_predefined = true;
-		m_predef		= 0;
+		if(!parse_calc(str))
+		{
+			m_is_predefined = true;
+			m_predef		= defValue;
+		}
 		return;
 	}
 
@@ -52,3 +247,59 @@ void litehtml::css_length::fromString( const tstring& str, const tstring& predef
 		}
 	}
 }
+
+bool litehtml::css_length::parse_calc(const tstring& str)
+{
+	calc_value val;
+	size_t pos = 0;
+	if(!calc_parse_factor(str, pos, val))
+	{
+		return false;
+	}
+	calc_skip_spaces(str, pos);
+	if(pos != str.length())
+	{
+		return false;
+	}
+
+	// pixels and percents are evaluated in calc_percent,
+	// other units are kept for document::cvt_units
+	float px = 0;
+	float percent = 0;
+	bool has_percent = false;
+	std::shared_ptr<css_calc_term::vector> terms;
+	for(const auto& term : val)
+	{
+		switch(term.units)
+		{
+		case css_units_none:
+		case css_units_px:
+			px += term.value;
+			break;
+		case css_units_percentage:
+			percent += term.value;
+			has_percent = true;
+			break;
+		default:
+			if(term.value != 0)
+			{
+				if(!terms)
+				{
+					terms = std::make_shared<css_calc_term::vector>();
+				}
+				terms->push_back(term);
+			}
+			break;
+		}
+	}
+	if(has_percent)
+	{
+		set_value(percent, css_units_percentage);
+		m_calc_px = px;
+	} else
+	{
+		set_value(px, css_units_px);
+	}
+	m_calc_terms = terms;
+	return true;
+}
@@ -1,6 +1,7 @@
 #include "html.h"
 #include "css_selector.h"
 #include "document.h"
+#include "string_pool.h"
 
 void litehtml::css_element_selector::parse( const tstring& txt )
 {
@@ -152,6 +153,10 @@ void litehtml::css_element_selector::parse( const tstring& txt )
 		}
 		el_end = txt.find_first_of(_t(".#[:"), el_end);
 	}
+	for(auto& attribute : m_attrs)
+	{
+		attribute.pooled_attribute = intern_string(attribute.attribute.c_str());
+	}
 }
 
 
@@ -3,8 +3,8 @@
 #include "stylesheet.h"
 #include "html_tag.h"
 #include "el_text.h"
+#include "el_text_run.h"
 #include "el_para.h"
-#include "el_space.h"
 #include "el_body.h"
 #include "el_image.h"
 #include "el_table.h"
@@ -25,13 +25,65 @@
 #include <math.h>
 #include <stdio.h>
 #include <algorithm>
+#include <set>
 #include "gumbo.h"
 #include "utf8_strings.h"
+#include "arena.h"
+#include "mapped_file.h"
+#include "task_pool.h"
+#include "string_pool.h"
+
+namespace
+{
+	void* gumbo_arena_allocate(void* userdata, size_t size)
+	{
+		return ((litehtml::arena*) userdata)->allocate(size);
+	}
+
+	void gumbo_arena_deallocate(void* userdata, void* ptr)
+	{
+		// everything is released together with the arena
+	}
+
+	// Parses the buffer taking all gumbo nodes, vectors and strings from parse_arena.
+	// The output must not be passed to gumbo_destroy_output.
+	GumboOutput* gumbo_parse_in_arena(litehtml::arena& parse_arena, const char* str, size_t length)
+	{
+		GumboOptions options = kGumboDefaultOptions;
+		options.allocator	= gumbo_arena_allocate;
+		options.deallocator	= gumbo_arena_deallocate;
+		options.userdata	= &parse_arena;
+		return gumbo_parse_with_options(&options, str, length);
+	}
+
+	// gumbo needs a few times more memory than the input size; the first block
+	// covers small documents, large ones grow in 1MB steps
+	size_t gumbo_arena_block_size(size_t length)
+	{
+		return std::min(std::max(length * 4, (size_t) 16 * 1024), (size_t) 1024 * 1024);
+	}
+}
 
 litehtml::document::document(litehtml::document_container* objContainer, litehtml::context* ctx)
 {
 	m_container	= objContainer;
 	m_context	= ctx;
+	m_pending_imports	= 0;
+	m_layout_generation	= 0;
+	m_user_styles		= 0;
+	m_parse_arena_high_water	= 0;
+	m_layout_limited		= false;
+	m_layout_bottom			= -1;
+	m_has_layout_deadline	= false;
+	m_layout_done_bottom	= 0;
+	m_layout_cancel			= 0;
+	m_layout_stopped		= false;
+	m_pending_height	= 0;
+	m_layout_progress	= 0;
+	m_layout_width		= -1;
+	m_viewport_units	= false;
+	// element storage lives as long as the document or the last element still referenced
+	m_elements_arena	= std::make_shared<arena>();
 }
 
 litehtml::document::~document()
@@ -53,78 +105,225 @@ litehtml::document::ptr litehtml::document::createFromString( const tchar_t* str
 
 litehtml::document::ptr litehtml::document::createFromUTF8(const char* str, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles)
 {
-	// parse document into GumboOutput
-	GumboOutput* output = gumbo_parse((const char*) str);
+	return createFromBuffer(str, strlen(str), objPainter, ctx, user_styles);
+}
+
+litehtml::document::ptr litehtml::document::createFromBuffer(const char* data, size_t length, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles)
+{
+	litehtml::document::ptr doc = std::make_shared<litehtml::document>(objPainter, ctx);
+
+	doc->create_elements(data, length);
+	doc->apply_styles(user_styles);
+
+	return doc;
+}
+
+litehtml::document::ptr litehtml::document::createFromFile(const char* path, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles)
+{
+	litehtml::document::ptr doc;
+	{
+		mapped_file file;
+		if (!file.open(path))
+		{
+			return doc;
+		}
+		doc = std::make_shared<litehtml::document>(objPainter, ctx);
+		doc->create_elements(file.data(), file.size());
+		// the elements own copies of the text, the file can be unmapped before styling
+	}
+	doc->apply_styles(user_styles);
+
+	return doc;
+}
+
+void litehtml::document::createFromStringAsync(const tchar_t* str, litehtml::document_container* objPainter, litehtml::context* ctx, const ready_callback& on_ready, litehtml::css* user_styles)
+{
+	createFromUTF8Async(litehtml_to_utf8(str), objPainter, ctx, on_ready, user_styles);
+}
 
-	// Create litehtml::document
+void litehtml::document::createFromUTF8Async(const char* str, litehtml::document_container* objPainter, litehtml::context* ctx, const ready_callback& on_ready, litehtml::css* user_styles)
+{
 	litehtml::document::ptr doc = std::make_shared<litehtml::document>(objPainter, ctx);
+	doc->m_on_ready		= on_ready;
+	doc->m_user_styles	= user_styles;
+
+	doc->create_elements(str, strlen(str));
+
+	// Hold one reference until all stylesheets are requested, so the styles
+	// are not applied before the last request is started
+	doc->m_pending_imports = 1;
+	if (doc->m_root)
+	{
+		doc->request_linked_css(doc->m_root);
+	}
+	doc->release_pending_import();
+}
+
+void litehtml::document::create_elements(const char* str, size_t length)
+{
+	arena parse_arena(gumbo_arena_block_size(length));
+
+	// parse document into GumboOutput
+	GumboOutput* output = gumbo_parse_in_arena(parse_arena, str, length);
 
 	// Create litehtml::elements.
 	elements_vector root_elements;
-	doc->create_node(output->root, root_elements, true);
+	create_node(output->root, root_elements, true);
 	if (!root_elements.empty())
 	{
-		doc->m_root = root_elements.back();
+		m_root = root_elements.back();
 	}
-	// Destroy GumboOutput
-	gumbo_destroy_output(&kGumboDefaultOptions, output);
 
-	// Let's process created elements tree
-	if (doc->m_root)
+	// GumboOutput is destroyed with the arena
+	m_parse_arena_high_water = std::max(m_parse_arena_high_water, parse_arena.high_water());
+}
+
+void litehtml::document::apply_styles(litehtml::css* user_styles)
+{
+	if (!m_root)
 	{
-		doc->container()->get_media_features(doc->m_media);
+		return;
+	}
 
-		// apply master CSS
-		doc->m_root->apply_stylesheet(ctx->master_css());
+	container()->get_media_features(m_media);
 
-		// parse elements attributes
-		doc->m_root->parse_attributes();
+	// apply master CSS
+	m_root->apply_stylesheet(m_context->master_css());
 
-		// parse style sheets linked in document
-		media_query_list::ptr media;
-		for (css_text::vector::iterator css = doc->m_css.begin(); css != doc->m_css.end(); css++)
+	// parse elements attributes
+	m_root->parse_attributes();
+
+	// parse style sheets linked in document
+	media_query_list::ptr media;
+	for (css_text::vector::iterator css = m_css.begin(); css != m_css.end(); css++)
+	{
+		if (!css->media.empty())
 		{
-			if (!css->media.empty())
-			{
-				media = media_query_list::create_from_string(css->media, doc);
-			}
-			else
-			{
-				media = 0;
-			}
-			doc->m_styles.parse_stylesheet(css->text.c_str(), css->baseurl.c_str(), doc, media);
+			media = media_query_list::create_from_string(css->media, shared_from_this());
 		}
-		// Sort css selectors using CSS rules.
-		doc->m_styles.sort_selectors();
-
-		// get current media features
-		if (!doc->m_media_lists.empty())
+		else
 		{
-			doc->update_media_lists(doc->m_media);
+			media = 0;
 		}
+		m_styles.parse_stylesheet(css->text.c_str(), css->baseurl.c_str(), shared_from_this(), media);
+	}
+	// Sort css selectors using CSS rules.
+	m_styles.sort_selectors();
 
-		// Apply parsed styles.
-		doc->m_root->apply_stylesheet(doc->m_styles);
+	// get current media features
+	if (!m_media_lists.empty())
+	{
+		update_media_lists(m_media);
+	}
+
+	// Apply parsed styles.
+	m_root->apply_stylesheet(m_styles);
+
+	// Apply user styles if any
+	if (user_styles)
+	{
+		m_root->apply_stylesheet(*user_styles);
+	}
+
+	// Parse applied styles in the elements
+	m_root->parse_styles();
+
+	// Now the m_tabular_elements is filled with tabular elements.
+	// We have to check the tabular elements for missing table elements 
+	// and create the anonymous boxes in visual table layout
+	fix_tables_layout();
 
-		// Apply user styles if any
-		if (user_styles)
+	// Fanaly initialize elements
+	m_root->init();
+}
+
+void litehtml::document::request_linked_css(const element::ptr& el)
+{
+	const tchar_t* tag = el->get_tagName();
+	if (!t_strcmp(tag, _t("link")))
+	{
+		const tchar_t* rel = el->get_attr(_t("rel"));
+		const tchar_t* href = el->get_attr(_t("href"));
+		if (rel && !t_strcmp(rel, _t("stylesheet")) && href && href[0])
 		{
-			doc->m_root->apply_stylesheet(*user_styles);
+			request_css(href, _t(""));
 		}
+	}
+	else if (!t_strcmp(tag, _t("style")))
+	{
+		tstring text;
+		el->get_text(text);
+		string_vector urls;
+		css::collect_imports(text.c_str(), urls);
+		for (auto& url : urls)
+		{
+			request_css(url, _t(""));
+		}
+		return;
+	}
+	for (auto& child : el->m_children)
+	{
+		request_linked_css(child);
+	}
+}
 
-		// Parse applied styles in the elements
-		doc->m_root->parse_styles();
+void litehtml::document::request_css(const tstring& url, const tstring& baseurl)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_imported_css_mutex);
+		if (!m_imported_css.insert(std::make_pair(std::make_pair(url, baseurl), css_text())).second)
+		{
+			// already requested
+			return;
+		}
+		m_pending_imports++;
+	}
+	document::ptr this_doc = shared_from_this();
+	m_container->import_css_async(url, baseurl,
+		[this_doc, url, baseurl](const tstring& text, const tstring& css_baseurl)
+		{
+			this_doc->on_css_loaded(url, baseurl, text, css_baseurl);
+		}
+	);
+}
 
-		// Now the m_tabular_elements is filled with tabular elements.
-		// We have to check the tabular elements for missing table elements 
-		// and create the anonymous boxes in visual table layout
-		doc->fix_tables_layout();
+void litehtml::document::on_css_loaded(const tstring& url, const tstring& baseurl, const tstring& text, const tstring& css_baseurl)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_imported_css_mutex);
+		css_text& css = m_imported_css[std::make_pair(url, baseurl)];
+		css.text	= text;
+		css.baseurl	= css_baseurl;
+	}
 
-		// Fanaly initialize elements
-		doc->m_root->init();
+	// request nested imports before this one is released
+	string_vector urls;
+	css::collect_imports(text.c_str(), urls);
+	for (auto& import_url : urls)
+	{
+		request_css(import_url, css_baseurl);
 	}
+	release_pending_import();
+}
 
-	return doc;
+void litehtml::document::release_pending_import()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_imported_css_mutex);
+		if (--m_pending_imports > 0)
+		{
+			return;
+		}
+	}
+	apply_styles(m_user_styles);
+
+	ready_callback on_ready;
+	std::swap(on_ready, m_on_ready);
+	m_user_styles = 0;
+	if (on_ready)
+	{
+		on_ready(shared_from_this());
+	}
 }
 
 litehtml::uint_ptr litehtml::document::add_font( const tchar_t* name, int size, const tchar_t* weight, const tchar_t* style, const tchar_t* decoration, font_metrics* fm )
@@ -267,7 +466,33 @@ int litehtml::document::render( int max_width, render_type rt )
 			m_root->render_positioned(rt);
 		} else
 		{
+			m_images.erase(std::remove_if(m_images.begin(), m_images.end(),
+				[](const std::weak_ptr<el_image>& img) { return img.expired(); }), m_images.end());
+			for(const auto& img_ref : m_images)
+			{
+				std::shared_ptr<el_image> img = img_ref.lock();
+				// images removed from the tree are checked again once they are added back
+				element::ptr top = img;
+				while(top->have_parent())
+				{
+					top = top->parent();
+				}
+				if(top == m_root)
+				{
+					img->update_image_size();
+				}
+			}
+			if(!m_layout_stopped || max_width != m_layout_width)
+			{
+				m_layout_progress = 0;
+			}
+			m_layout_width		= max_width;
+			m_layout_stopped	= false;
+			m_pending_height	= 0;
+			// elements that were not changed since the last render keep their layout
+			m_layout_generation++;
 			ret = m_root->render(0, 0, max_width);
+			m_layout_generation++;
 			if(m_root->fetch_positioned())
 			{
 				m_fixed_boxes.clear();
@@ -276,11 +501,81 @@ int litehtml::document::render( int max_width, render_type rt )
 			m_size.width	= 0;
 			m_size.height	= 0;
 			m_root->calc_document_size(m_size);
+			// the estimate of the height left may grow as more content is laid out
+			m_layout_progress = std::max(m_layout_progress, (float) m_size.height / (float) std::max(m_size.height + m_pending_height, 1));
 		}
 	}
 	return ret;
 }
 
+int litehtml::document::render_partial(int max_width, int bottom)
+{
+	m_layout_limited	= true;
+	m_layout_bottom		= std::max(bottom, 0);
+	render(max_width);
+	m_layout_limited	= false;
+	m_layout_bottom		= -1;
+	return m_size.height + m_pending_height;
+}
+
+int litehtml::document::render_partial(int max_width, std::chrono::steady_clock::time_point deadline, const std::atomic<bool>* cancel)
+{
+	m_layout_limited		= true;
+	m_has_layout_deadline	= true;
+	m_layout_deadline		= deadline;
+	m_layout_cancel			= cancel;
+	// the layout goes past the content laid out by the last call before it stops
+	m_layout_done_bottom	= m_layout_stopped ? m_size.height : 0;
+	render(max_width);
+	m_layout_limited		= false;
+	m_has_layout_deadline	= false;
+	m_layout_cancel			= 0;
+	return m_size.height + m_pending_height;
+}
+
+float litehtml::document::layout_progress() const
+{
+	if(!m_layout_stopped)
+	{
+		return 1;
+	}
+	return m_layout_progress;
+}
+
+bool litehtml::document::should_stop_layout(int y) const
+{
+	if(m_layout_stopped)
+	{
+		return true;
+	}
+	if(m_layout_bottom >= 0 && y >= m_layout_bottom)
+	{
+		return true;
+	}
+	if(m_layout_cancel && m_layout_cancel->load(std::memory_order_relaxed))
+	{
+		return true;
+	}
+	return m_has_layout_deadline && y > m_layout_done_bottom && std::chrono::steady_clock::now() >= m_layout_deadline;
+}
+
+void litehtml::document::stop_layout(int pending_height)
+{
+	m_layout_stopped	= true;
+	m_pending_height	+= pending_height;
+}
+
+void litehtml::document::set_layout_threads(int count)
+{
+	if(count <= 1)
+	{
+		m_layout_pool = nullptr;
+	} else if(!m_layout_pool || m_layout_pool->threads_count() != count - 1)
+	{
+		m_layout_pool.reset(new task_pool(count - 1));
+	}
+}
+
 void litehtml::document::draw( uint_ptr hdc, int x, int y, const position* clip )
 {
 	if(m_root)
@@ -309,6 +604,19 @@ int litehtml::document::cvt_units( css_length& val, int fontSize, int size ) con
 	{
 		return 0;
 	}
+	if(val.calc_terms())
+	{
+		// the calc() terms are converted on every call, they may depend on the viewport;
+		// the rest of the length is pixels plus percentage
+		int px = 0;
+		for(const auto& term : *val.calc_terms())
+		{
+			css_length term_val;
+			term_val.set_value(term.value, term.units);
+			px += cvt_units(term_val, fontSize, size);
+		}
+		return val.calc_percent(size) + px;
+	}
 	int ret = 0;
 	switch(val.units())
 	{
@@ -336,15 +644,19 @@ int litehtml::document::cvt_units( css_length& val, int fontSize, int size ) con
 		val.set_value((float) ret, css_units_px);
 		break;
 	case css_units_vw:
+		m_viewport_units = true;
 		ret = (int)((double)m_media.width * (double)val.val() / 100.0);
 		break;
 	case css_units_vh:
+		m_viewport_units = true;
 		ret = (int)((double)m_media.height * (double)val.val() / 100.0);
 		break;
 	case css_units_vmin:
+		m_viewport_units = true;
 		ret = (int)((double)std::min(m_media.height, m_media.width) * (double)val.val() / 100.0);
 		break;
 	case css_units_vmax:
+		m_viewport_units = true;
 		ret = (int)((double)std::max(m_media.height, m_media.width) * (double)val.val() / 100.0);
 		break;
 	case css_units_rem:
@@ -358,6 +670,14 @@ int litehtml::document::cvt_units( css_length& val, int fontSize, int size ) con
 	return ret;
 }
 
+litehtml::size litehtml::document::viewport_size() const
+{
+	litehtml::size sz;
+	sz.width	= m_media.width;
+	sz.height	= m_media.height;
+	return sz;
+}
+
 int litehtml::document::width() const
 {
 	return m_size.width;
@@ -376,6 +696,72 @@ void litehtml::document::add_stylesheet( const tchar_t* str, const tchar_t* base
 	}
 }
 
+void litehtml::document::import_css(tstring& text, const tstring& url, tstring& baseurl)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_imported_css_mutex);
+		imported_css_map::iterator css = m_imported_css.find(std::make_pair(url, baseurl));
+		if(css != m_imported_css.end())
+		{
+			text	= css->second.text;
+			baseurl	= css->second.baseurl;
+			return;
+		}
+	}
+	m_container->import_css(text, url, baseurl);
+}
+
+// Adds the stylesheet to the already created document. Only the new selectors are matched
+// against the elements, the elements they match are restyled. Returns true if any element
+// was changed, so the document has to be rendered again.
+bool litehtml::document::append_stylesheet(const tchar_t* str, const tchar_t* baseurl, const tchar_t* media)
+{
+	if(!m_root || !str || !str[0])
+	{
+		return false;
+	}
+
+	media_query_list::ptr media_list;
+	if(media && media[0])
+	{
+		media_list = media_query_list::create_from_string(media, shared_from_this());
+	}
+	litehtml::css stylesheet;
+	stylesheet.parse_stylesheet(str, baseurl, shared_from_this(), media_list);
+	if(stylesheet.selectors().empty())
+	{
+		return false;
+	}
+	m_styles.merge(stylesheet);
+
+	// new media lists have to be checked before matching
+	update_media_lists(m_media);
+
+	elements_vector changed;
+	m_root->apply_appended_stylesheet(stylesheet, m_context->master_css(), m_styles, changed);
+
+	std::set<const element*> changed_set;
+	for(auto& el : changed)
+	{
+		changed_set.insert(el.get());
+	}
+	for(auto& el : changed)
+	{
+		// the subtree of the changed ancestor is restyled with it
+		bool is_nested = false;
+		for(element::ptr el_parent = el->parent(); el_parent && !is_nested; el_parent = el_parent->parent())
+		{
+			is_nested = changed_set.count(el_parent.get()) != 0;
+		}
+		if(!is_nested)
+		{
+			el->refresh_styles();
+			el->parse_styles();
+		}
+	}
+	return !changed.empty();
+}
+
 bool litehtml::document::on_mouse_over( int x, int y, int client_x, int client_y, position::vector& redraw_boxes )
 {
 	if(!m_root)
@@ -503,76 +889,84 @@ bool litehtml::document::on_lbutton_up( int x, int y, int client_x, int client_y
 }
 
 litehtml::element::ptr litehtml::document::create_element(const tchar_t* tag_name, const string_map& attributes)
+{
+	element::ptr newTag = create_tag(tag_name, attributes);
+	if(newTag)
+	{
+		for (string_map::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+		{
+			newTag->set_attr(iter->first.c_str(), iter->second.c_str());
+		}
+	}
+	return newTag;
+}
+
+litehtml::element::ptr litehtml::document::create_tag(const tchar_t* tag_name, const string_map& attributes)
 {
 	element::ptr newTag;
-	document::ptr this_doc = shared_from_this();
-	if(m_container)
+	if(m_container && m_container->creates_elements())
 	{
-		newTag = m_container->create_element(tag_name, attributes, this_doc);
+		newTag = m_container->create_element(tag_name, attributes, shared_from_this());
 	}
 	if(!newTag)
 	{
 		if(!t_strcmp(tag_name, _t("br")))
 		{
-			newTag = std::make_shared<litehtml::el_break>(this_doc);
+			newTag = make_element<litehtml::el_break>();
 		} else if(!t_strcmp(tag_name, _t("p")))
 		{
-			newTag = std::make_shared<litehtml::el_para>(this_doc);
+			newTag = make_element<litehtml::el_para>();
 		} else if(!t_strcmp(tag_name, _t("img")))
 		{
-			newTag = std::make_shared<litehtml::el_image>(this_doc);
+			newTag = make_element<litehtml::el_image>();
 		} else if(!t_strcmp(tag_name, _t("table")))
 		{
-			newTag = std::make_shared<litehtml::el_table>(this_doc);
+			newTag = make_element<litehtml::el_table>();
 		} else if(!t_strcmp(tag_name, _t("td")) || !t_strcmp(tag_name, _t("th")))
 		{
-			newTag = std::make_shared<litehtml::el_td>(this_doc);
+			newTag = make_element<litehtml::el_td>();
 		} else if(!t_strcmp(tag_name, _t("link")))
 		{
-			newTag = std::make_shared<litehtml::el_link>(this_doc);
+			newTag = make_element<litehtml::el_link>();
 		} else if(!t_strcmp(tag_name, _t("title")))
 		{
-			newTag = std::make_shared<litehtml::el_title>(this_doc);
+			newTag = make_element<litehtml::el_title>();
 		} else if(!t_strcmp(tag_name, _t("a")))
 		{
-			newTag = std::make_shared<litehtml::el_anchor>(this_doc);
+			newTag = make_element<litehtml::el_anchor>();
 		} else if(!t_strcmp(tag_name, _t("tr")))
 		{
-			newTag = std::make_shared<litehtml::el_tr>(this_doc);
+			newTag = make_element<litehtml::el_tr>();
 		} else if(!t_strcmp(tag_name, _t("style")))
 		{
-			newTag = std::make_shared<litehtml::el_style>(this_doc);
+			newTag = make_element<litehtml::el_style>();
 		} else if(!t_strcmp(tag_name, _t("base")))
 		{
-			newTag = std::make_shared<litehtml::el_base>(this_doc);
+			newTag = make_element<litehtml::el_base>();
 		} else if(!t_strcmp(tag_name, _t("body")))
 		{
-			newTag = std::make_shared<litehtml::el_body>(this_doc);
+			newTag = make_element<litehtml::el_body>();
 		} else if(!t_strcmp(tag_name, _t("div")))
 		{
-			newTag = std::make_shared<litehtml::el_div>(this_doc);
+			newTag = make_element<litehtml::el_div>();
 		} else if(!t_strcmp(tag_name, _t("script")))
 		{
-			newTag = std::make_shared<litehtml::el_script>(this_doc);
+			newTag = make_element<litehtml::el_script>();
 		} else if(!t_strcmp(tag_name, _t("font")))
 		{
-			newTag = std::make_shared<litehtml::el_font>(this_doc);
+			newTag = make_element<litehtml::el_font>();
 		} else if(!t_strcmp(tag_name, _t("li")))
 		{
-			newTag = std::make_shared<litehtml::el_li>(this_doc);
+			newTag = make_element<litehtml::el_li>();
 		} else
 		{
-			newTag = std::make_shared<litehtml::html_tag>(this_doc);
+			newTag = make_element<litehtml::html_tag>();
 		}
 	}
 
 	if(newTag)
 	{
 		newTag->set_tagName(tag_name);
-		for (string_map::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
-		{
-			newTag->set_attr(iter->first.c_str(), iter->second.c_str());
-		}
 	}
 
 	return newTag;
@@ -588,6 +982,29 @@ void litehtml::document::add_fixed_box( const position& pos )
 	m_fixed_boxes.push_back(pos);
 }
 
+const litehtml::tchar_t* litehtml::document::attribute_name(const tstring& name, bool& is_pooled)
+{
+	const tchar_t* pooled = find_interned_string(name.c_str());
+	is_pooled = pooled != 0;
+	if(pooled)
+	{
+		return pooled;
+	}
+	auto iter = m_attr_names.find(name);
+	if(iter == m_attr_names.end())
+	{
+		// the elements may outlive the document, their arena stays with them
+		tchar_t* copy = (tchar_t*) m_elements_arena->allocate((name.length() + 1) * sizeof(tchar_t));
+		if(!copy)
+		{
+			throw std::bad_alloc();
+		}
+		memcpy(copy, name.c_str(), (name.length() + 1) * sizeof(tchar_t));
+		iter = m_attr_names.insert(std::make_pair(name, (const tchar_t*) copy)).first;
+	}
+	return iter->second;
+}
+
 bool litehtml::document::media_changed()
 {
 	if(!m_media_lists.empty())
@@ -597,6 +1014,7 @@ bool litehtml::document::media_changed()
 		{
 			m_root->refresh_styles();
 			m_root->parse_styles();
+			m_layout_progress = 0;
 			return true;
 		}
 	}
@@ -626,6 +1044,15 @@ bool litehtml::document::lang_changed()
 
 bool litehtml::document::update_media_lists(const media_features& features)
 {
+	int_vector signature;
+	m_media_breakpoints.get_signature(features, signature);
+	if(signature == m_media_signature)
+	{
+		// no breakpoint is crossed, so every media list keeps its state
+		return false;
+	}
+	m_media_signature = signature;
+
 	bool update_styles = false;
 	for(media_query_list::vector::iterator iter = m_media_lists.begin(); iter != m_media_lists.end(); iter++)
 	{
@@ -644,6 +1071,8 @@ void litehtml::document::add_media_list( media_query_list::ptr list )
 		if(std::find(m_media_lists.begin(), m_media_lists.end(), list) == m_media_lists.end())
 		{
 			m_media_lists.push_back(list);
+			list->add_breakpoints(m_media_breakpoints);
+			m_media_signature.clear();
 		}
 	}
 }
@@ -655,20 +1084,25 @@ void litehtml::document::create_node(void* gnode, elements_vector& elements, boo
 	{
 	case GUMBO_NODE_ELEMENT:
 		{
+			// the string_map is only needed by document_container::create_element,
+			// otherwise the elements take their attributes straight from gumbo
+			const GumboVector& gumbo_attrs = node->v.element.attributes;
+			bool use_map = m_container && m_container->creates_elements();
 			string_map attrs;
-			GumboAttribute* attr;
-			for (unsigned int i = 0; i < node->v.element.attributes.length; i++)
+			if (use_map)
 			{
-				attr = (GumboAttribute*)node->v.element.attributes.data[i];
-				attrs[tstring(litehtml_from_utf8(attr->name))] = litehtml_from_utf8(attr->value);
+				for (unsigned int i = 0; i < gumbo_attrs.length; i++)
+				{
+					GumboAttribute* attr = (GumboAttribute*)gumbo_attrs.data[i];
+					attrs[tstring(litehtml_from_utf8(attr->name))] = litehtml_from_utf8(attr->value);
+				}
 			}
 
-
 			element::ptr ret;
 			const char* tag = gumbo_normalized_tagname(node->v.element.tag);
 			if (tag[0])
 			{
-				ret = create_element(litehtml_from_utf8(tag), attrs);
+				ret = create_tag(litehtml_from_utf8(tag), attrs);
 			}
 			else
 			{
@@ -677,7 +1111,21 @@ void litehtml::document::create_node(void* gnode, elements_vector& elements, boo
 					std::string strA;
 					gumbo_tag_from_original_text(&node->v.element.original_tag);
 					strA.append(node->v.element.original_tag.data, node->v.element.original_tag.length);
-					ret = create_element(litehtml_from_utf8(strA.c_str()), attrs);
+					ret = create_tag(litehtml_from_utf8(strA.c_str()), attrs);
+				}
+			}
+			if (ret && use_map)
+			{
+				for (const auto& attr : attrs)
+				{
+					ret->set_attr(attr.first.c_str(), attr.second.c_str());
+				}
+			} else if (ret)
+			{
+				for (unsigned int i = 0; i < gumbo_attrs.length; i++)
+				{
+					GumboAttribute* attr = (GumboAttribute*)gumbo_attrs.data[i];
+					ret->set_attr(litehtml_from_utf8(attr->name), litehtml_from_utf8(attr->value));
 				}
 			}
 			if (!strcmp(tag, "script"))
@@ -704,72 +1152,33 @@ void litehtml::document::create_node(void* gnode, elements_vector& elements, boo
 		break;
 	case GUMBO_NODE_TEXT:
 		{
-			std::wstring str;
-			std::wstring str_in = (const wchar_t*) (utf8_to_wchar(node->v.text.text));
 			if (!parseTextNode)
 			{
-				elements.push_back(std::make_shared<el_text>(litehtml_from_wchar(str_in.c_str()), shared_from_this()));
-				break;
+				elements.push_back(make_element<el_text>(litehtml_from_utf8(node->v.text.text)));
 			}
-			ucode_t c;
-			for (size_t i = 0; i < str_in.length(); i++)
-			{
-				c = (ucode_t) str_in[i];
-				if (c <= ' ' && (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'))
-				{
-					if (!str.empty())
-					{
-						elements.push_back(std::make_shared<el_text>(litehtml_from_wchar(str.c_str()), shared_from_this()));
-						str.clear();
-					}
-					str += c;
-					elements.push_back(std::make_shared<el_space>(litehtml_from_wchar(str.c_str()), shared_from_this()));
-					str.clear();
-				}
-				// CJK character range
-				else if (c >= 0x4E00 && c <= 0x9FCC)
-				{
-					if (!str.empty())
-					{
-						elements.push_back(std::make_shared<el_text>(litehtml_from_wchar(str.c_str()), shared_from_this()));
-						str.clear();
-					}
-					str += c;
-					elements.push_back(std::make_shared<el_text>(litehtml_from_wchar(str.c_str()), shared_from_this()));
-					str.clear();
-				}
-				else
-				{
-					str += c;
-				}
-			}
-			if (!str.empty())
+			else
 			{
-				elements.push_back(std::make_shared<el_text>(litehtml_from_wchar(str.c_str()), shared_from_this()));
+				elements.push_back(make_element<el_text_run>(node->v.text.text));
 			}
 		}
 		break;
 	case GUMBO_NODE_CDATA:
 		{
-			element::ptr ret = std::make_shared<el_cdata>(shared_from_this());
+			element::ptr ret = make_element<el_cdata>();
 			ret->set_data(litehtml_from_utf8(node->v.text.text));
 			elements.push_back(ret);
 		}
 		break;
 	case GUMBO_NODE_COMMENT:
 		{
-			element::ptr ret = std::make_shared<el_comment>(shared_from_this());
+			element::ptr ret = make_element<el_comment>();
 			ret->set_data(litehtml_from_utf8(node->v.text.text));
 			elements.push_back(ret);
 		}
 		break;
 	case GUMBO_NODE_WHITESPACE:
 		{
-			tstring str = litehtml_from_utf8(node->v.text.text);
-			for (size_t i = 0; i < str.length(); i++)
-			{
-				elements.push_back(std::make_shared<el_space>(str.substr(i, 1).c_str(), shared_from_this()));
-			}
+			elements.push_back(make_element<el_text_run>(node->v.text.text));
 		}
 		break;
 	default:
@@ -829,7 +1238,7 @@ void litehtml::document::fix_table_children(element::ptr& el_ptr, style_display
 
 	auto flush_elements = [&]()
 	{
-		element::ptr annon_tag = std::make_shared<html_tag>(shared_from_this());
+		element::ptr annon_tag = make_element<html_tag>();
 		style st;
 		st.add_property(_t("display"), disp_str, 0, false);
 		annon_tag->add_style(st);
@@ -936,7 +1345,7 @@ void litehtml::document::fix_table_parent(element::ptr& el_ptr, style_display di
 			}
 
 			// extract elements with the same display and wrap them with anonymous object
-			element::ptr annon_tag = std::make_shared<html_tag>(shared_from_this());
+			element::ptr annon_tag = make_element<html_tag>();
 			style st;
 			st.add_property(_t("display"), disp_str, 0, false);
 			annon_tag->add_style(st);
@@ -967,15 +1376,18 @@ void litehtml::document::append_children_from_utf8(element& parent, const char*
 		return;
 	}
 
+	size_t length = strlen(str);
+	arena parse_arena(gumbo_arena_block_size(length));
+
 	// parse document into GumboOutput
-	GumboOutput* output = gumbo_parse((const char*) str);
+	GumboOutput* output = gumbo_parse_in_arena(parse_arena, str, length);
 
 	// Create litehtml::elements.
 	elements_vector child_elements;
 	create_node(output->root, child_elements, true);
 
-	// Destroy GumboOutput
-	gumbo_destroy_output(&kGumboDefaultOptions, output);
+	// GumboOutput is destroyed with the arena
+	m_parse_arena_high_water = std::max(m_parse_arena_high_water, parse_arena.high_water());
 
 	// Let's process created elements tree
 	for (litehtml::element::ptr child : child_elements)
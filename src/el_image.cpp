@@ -5,6 +5,7 @@
 litehtml::el_image::el_image(const std::shared_ptr<litehtml::document>& doc) : html_tag(doc)
 {
 	m_display = display_inline_block;
+	m_rendered = false;
 }
 
 litehtml::el_image::~el_image( void )
@@ -17,6 +18,23 @@ void litehtml::el_image::get_content_size( size& sz, int max_width )
 	get_document()->container()->get_image_size(m_src.c_str(), 0, sz);
 }
 
+bool litehtml::el_image::update_image_size()
+{
+	if(!m_rendered)
+	{
+		return false;
+	}
+	size sz;
+	get_document()->container()->get_image_size(m_src.c_str(), 0, sz);
+	if(sz.width == m_layout_image_size.width && sz.height == m_layout_image_size.height)
+	{
+		return false;
+	}
+	m_layout_image_size = sz;
+	invalidate_layout();
+	return true;
+}
+
 int litehtml::el_image::calc_max_height(int image_height)
 {
 	document::ptr doc = get_document();
@@ -57,6 +75,8 @@ int litehtml::el_image::render( int x, int y, int max_width, bool second_pass )
 
 	litehtml::size sz;
 	doc->container()->get_image_size(m_src.c_str(), 0, sz);
+	m_layout_image_size	= sz;
+	m_rendered			= true;
 
 	m_pos.width		= sz.width;
 	m_pos.height	= sz.height;
@@ -125,7 +145,7 @@ int litehtml::el_image::render( int x, int y, int max_width, bool second_pass )
 		}
 	} else if(m_css_height.is_predefined() && !m_css_width.is_predefined())
 	{
-		m_pos.width = (int) m_css_width.calc_percent(parent_width);
+		m_pos.width = (int) doc->cvt_units(m_css_width, m_font_size, parent_width);
 
 		// check for max-width
 		if(!m_css_max_width.is_predefined())
@@ -146,7 +166,7 @@ int litehtml::el_image::render( int x, int y, int max_width, bool second_pass )
 		}
 	} else
 	{
-		m_pos.width		= (int) m_css_width.calc_percent(parent_width);
+		m_pos.width		= (int) doc->cvt_units(m_css_width, m_font_size, parent_width);
 		m_pos.height	= 0;
 		if (!get_predefined_height(m_pos.height))
 		{
@@ -185,6 +205,7 @@ int litehtml::el_image::render( int x, int y, int max_width, bool second_pass )
 void litehtml::el_image::parse_attributes()
 {
 	m_src = get_attr(_t("src"), _t(""));
+	get_document()->add_image(std::static_pointer_cast<el_image>(shared_from_this()));
 
 	const tchar_t* attr_height = get_attr(_t("height"));
 	if(attr_height)
@@ -235,7 +256,7 @@ void litehtml::el_image::draw( uint_ptr hdc, int x, int y, const position* clip
 			bg.repeat				= background_repeat_no_repeat;
 			bg.image_size.width		= pos.width;
 			bg.image_size.height	= pos.height;
-			bg.border_radius		= m_css_borders.radius.calc_percents(bg.border_box.width, bg.border_box.height);
+			bg.border_radius		= m_css_borders.radius.calc_percents(*get_document(), m_font_size, bg.border_box.width, bg.border_box.height);
 			bg.position_x			= pos.x;
 			bg.position_y			= pos.y;
 			get_document()->container()->draw_background(hdc, bg);
@@ -250,7 +271,7 @@ void litehtml::el_image::draw( uint_ptr hdc, int x, int y, const position* clip
 		border_box += m_borders;
 
 		borders bdr = m_css_borders;
-		bdr.radius = m_css_borders.radius.calc_percents(border_box.width, border_box.height);
+		bdr.radius = m_css_borders.radius.calc_percents(*get_document(), m_font_size, border_box.width, border_box.height);
 
 		get_document()->container()->draw_borders(hdc, bdr, border_box, have_parent() ? false : true);
 	}
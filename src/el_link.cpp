@@ -28,7 +28,7 @@ void litehtml::el_link::parse_attributes()
 		{
 			tstring css_text;
 			tstring css_baseurl;
-			doc->container()->import_css(css_text, href, css_baseurl);
+			doc->import_css(css_text, href, css_baseurl);
 			if(!css_text.empty())
 			{
 				doc->add_stylesheet(css_text.c_str(), css_baseurl.c_str(), media);
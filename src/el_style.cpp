@@ -16,11 +16,7 @@ litehtml::el_style::~el_style()
 void litehtml::el_style::parse_attributes()
 {
 	tstring text;
-
-	for(auto& el : m_children)
-	{
-		el->get_text(text);
-	}
+	get_text(text);
 	get_document()->add_stylesheet( text.c_str(), 0, get_attr(_t("media")) );
 }
 
@@ -30,6 +26,14 @@ bool litehtml::el_style::appendChild(const ptr &el)
 	return true;
 }
 
+void litehtml::el_style::get_text(tstring& text)
+{
+	for(auto& el : m_children)
+	{
+		el->get_text(text);
+	}
+}
+
 const litehtml::tchar_t* litehtml::el_style::get_tagName() const
 {
 	return _t("style");
@@ -43,6 +43,8 @@ const litehtml::tchar_t* litehtml::el_text::get_style_property( const tchar_t* n
 
 void litehtml::el_text::parse_styles(bool is_reparse)
 {
+	invalidate_layout();
+
 	m_text_transform	= (text_transform)	value_index(get_style_property(_t("text-transform"), true,	_t("none")),	text_transform_strings,	text_transform_none);
 	if(m_text_transform != text_transform_none)
 	{
@@ -0,0 +1,529 @@
+#include "html.h"
+#include "el_text_run.h"
+#include "document.h"
+#include "box.h"
+#include "utf8_strings.h"
+
+litehtml::el_text_fragment::el_text_fragment(el_text_run* run, int word, const std::shared_ptr<litehtml::document>& doc) : el_text(0, doc)
+{
+	m_run			= run;
+	m_first_word	= word;
+	m_last_word		= word;
+	m_placed		= false;
+	m_draw_spaces	= run->m_draw_spaces;
+	m_white_space	= run->m_prefix_ws;
+
+	parent(run->parent());
+
+	const el_text_run::word& wrd = run->m_words[word];
+	m_size.width	= wrd.width;
+	m_size.height	= run->is_break_word(wrd, m_white_space) ? 0 : run->m_size.height;
+}
+
+litehtml::el_text_fragment::~el_text_fragment()
+{
+
+}
+
+litehtml::line_box* litehtml::el_text_fragment::get_line_box() const
+{
+	if(m_box && m_box->get_type() == box_line)
+	{
+		return static_cast<line_box*>(m_box);
+	}
+	return 0;
+}
+
+void litehtml::el_text_fragment::extend(int last_word, int width)
+{
+	m_last_word		= last_word;
+	m_size.width	+= width;
+	m_pos.width		+= width;
+}
+
+bool litehtml::el_text_fragment::is_white_space() const
+{
+	return m_first_word == m_last_word && m_run->is_white_space_word(m_run->m_words[m_first_word], get_white_space());
+}
+
+bool litehtml::el_text_fragment::is_break() const
+{
+	return m_first_word == m_last_word && m_run->is_break_word(m_run->m_words[m_first_word], get_white_space());
+}
+
+bool litehtml::el_text_fragment::is_text_run() const
+{
+	// once placed, the fragment is laid out again word by word through its run
+	return m_placed;
+}
+
+litehtml::white_space litehtml::el_text_fragment::get_white_space() const
+{
+	return m_white_space;
+}
+
+int litehtml::el_text_fragment::get_inline_shift_left()
+{
+	if(m_run->m_first_text_word >= m_first_word && m_run->m_first_text_word <= m_last_word)
+	{
+		return m_run->get_inline_shift_left();
+	}
+	return 0;
+}
+
+int litehtml::el_text_fragment::get_inline_shift_right()
+{
+	if(m_run->m_last_text_word >= m_first_word && m_run->m_last_text_word <= m_last_word)
+	{
+		return m_run->get_inline_shift_right();
+	}
+	return 0;
+}
+
+int litehtml::el_text_fragment::render_inline(const ptr &container, int max_width)
+{
+	element::ptr self = shared_from_this();
+	el_text_run* run = m_run;
+
+	size_t insert_at = run->remove_fragment(this);
+	return run->place_words(container, m_first_word, m_last_word, max_width, insert_at);
+}
+
+void litehtml::el_text_fragment::draw(uint_ptr hdc, int x, int y, const position* clip)
+{
+	position pos = m_pos;
+	pos.x	+= x;
+	pos.y	+= y;
+
+	element::ptr el_parent = parent();
+	if(!el_parent || !pos.does_intersect(clip))
+	{
+		return;
+	}
+
+	document::ptr doc = get_document();
+	white_space ws = el_parent->get_white_space();
+	uint_ptr font = el_parent->get_font();
+	litehtml::web_color color = el_parent->get_color(_t("color"), true, doc->get_def_color());
+
+	tstring text;
+	for(int i = m_first_word; i <= m_last_word; i++)
+	{
+		const el_text_run::word& wrd = m_run->m_words[i];
+		if(wrd.skip)
+		{
+			continue;
+		}
+		pos.width = wrd.width;
+		if((m_draw_spaces || !m_run->is_white_space_word(wrd, ws)) && pos.does_intersect(clip))
+		{
+			m_run->get_word_text(wrd, ws, text);
+			doc->container()->draw_text(hdc, text.c_str(), font, color, pos);
+		}
+		pos.x += wrd.width;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+litehtml::el_text_run::el_text_run(const char* utf8_text, const std::shared_ptr<litehtml::document>& doc) : el_text(0, doc)
+{
+	m_first_text_word	= -1;
+	m_last_text_word	= -1;
+	m_prefix_ws			= white_space_normal;
+
+	if(!utf8_text)
+	{
+		return;
+	}
+
+#ifdef LITEHTML_UTF8
+	m_text = utf8_text;
+	split_utf8_text(utf8_text,
+		[this, utf8_text](const char* str, size_t length, bool is_space)
+		{
+			add_word(str - utf8_text, length, is_space);
+		}
+	);
+#else
+	std::string piece;
+	split_utf8_text(utf8_text,
+		[this, &piece](const char* str, size_t length, bool is_space)
+		{
+			piece.assign(str, length);
+			size_t offset = m_text.length();
+			m_text += litehtml_from_utf8(piece.c_str());
+			add_word(offset, m_text.length() - offset, is_space);
+		}
+	);
+#endif
+}
+
+litehtml::el_text_run::~el_text_run()
+{
+
+}
+
+void litehtml::el_text_run::add_word(size_t offset, size_t length, bool is_space)
+{
+	word wrd;
+	wrd.offset				= (unsigned int) offset;
+	wrd.length				= (unsigned int) length;
+	wrd.transformed_offset	= 0;
+	wrd.transformed_length	= 0;
+	wrd.width				= 0;
+	wrd.is_space			= is_space;
+	wrd.skip				= false;
+	m_words.push_back(wrd);
+}
+
+bool litehtml::el_text_run::is_white_space_word(const word& wrd, white_space ws) const
+{
+	return wrd.is_space && (ws == white_space_normal || ws == white_space_nowrap || ws == white_space_pre_line);
+}
+
+bool litehtml::el_text_run::is_break_word(const word& wrd, white_space ws) const
+{
+	return wrd.is_space && m_text[wrd.offset] == _t('\n') &&
+		(ws == white_space_pre || ws == white_space_pre_line || ws == white_space_pre_wrap);
+}
+
+bool litehtml::el_text_run::is_collapsed_word(int i, white_space ws) const
+{
+	return i > 0 && is_white_space_word(m_words[i], ws) && is_white_space_word(m_words[i - 1], ws);
+}
+
+void litehtml::el_text_run::calc_prefix_widths(white_space ws)
+{
+	m_prefix_ws = ws;
+	m_prefix_widths.resize(m_words.size() + 1);
+	m_breaks.clear();
+	m_prefix_widths[0] = 0;
+	for(int i = 0; i < (int) m_words.size(); i++)
+	{
+		m_prefix_widths[i + 1] = m_prefix_widths[i] + (is_collapsed_word(i, ws) ? 0 : m_words[i].width);
+		if(is_break_word(m_words[i], ws))
+		{
+			m_breaks.push_back(i);
+		}
+	}
+}
+
+// The last word from first to last that ends a line taking up to room from the
+// start word on. A collapsible space is left for the word after it. Returns
+// first - 1 if the first word does not fit.
+int litehtml::el_text_run::fit_words(int start, int first, int last, int room) const
+{
+	int_vector::const_iterator i = std::upper_bound(m_prefix_widths.begin() + first + 1, m_prefix_widths.begin() + last + 2, m_prefix_widths[start] + room);
+	int ret = (int) (i - m_prefix_widths.begin()) - 2;
+	while(ret >= first && is_white_space_word(m_words[ret], m_prefix_ws))
+	{
+		ret--;
+	}
+	return ret;
+}
+
+void litehtml::el_text_run::get_word_text(const word& wrd, white_space ws, tstring& text) const
+{
+	if(wrd.is_space)
+	{
+		tchar_t ch = m_text[wrd.offset];
+		if(is_white_space_word(wrd, ws))
+		{
+			text = _t(" ");
+		} else if(ch == _t('\t'))
+		{
+			text = _t("    ");
+		} else if(ch == _t('\n') || ch == _t('\r'))
+		{
+			text.clear();
+		} else
+		{
+			text.assign(1, ch);
+		}
+	} else if(m_use_transformed)
+	{
+		text.assign(m_transformed_text, wrd.transformed_offset, wrd.transformed_length);
+	} else
+	{
+		text.assign(m_text, wrd.offset, wrd.length);
+	}
+}
+
+bool litehtml::el_text_run::is_white_space() const
+{
+	if(m_words.empty())
+	{
+		return false;
+	}
+	white_space ws = get_white_space();
+	for(const auto& wrd : m_words)
+	{
+		if(!is_white_space_word(wrd, ws))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool litehtml::el_text_run::is_text_run() const
+{
+	return true;
+}
+
+void litehtml::el_text_run::parse_styles(bool is_reparse)
+{
+	invalidate_layout();
+
+	m_text_transform	= (text_transform)	value_index(get_style_property(_t("text-transform"), true,	_t("none")),	text_transform_strings,	text_transform_none);
+	m_use_transformed	= m_text_transform != text_transform_none;
+	m_transformed_text.clear();
+
+	font_metrics fm;
+	uint_ptr font = 0;
+	element::ptr el_parent = parent();
+	if (el_parent)
+	{
+		font = el_parent->get_font(&fm);
+	}
+
+	document::ptr doc = get_document();
+	white_space ws = get_white_space();
+	tstring text;
+	for(auto& wrd : m_words)
+	{
+		if(m_use_transformed && !wrd.is_space)
+		{
+			text.assign(m_text, wrd.offset, wrd.length);
+			doc->container()->transform_text(text, m_text_transform);
+			wrd.transformed_offset	= (unsigned int) m_transformed_text.length();
+			wrd.transformed_length	= (unsigned int) text.length();
+			m_transformed_text		+= text;
+		}
+		if(is_break_word(wrd, ws))
+		{
+			wrd.width = 0;
+		} else
+		{
+			get_word_text(wrd, ws, text);
+			wrd.width = doc->container()->text_width(text.c_str(), font);
+		}
+	}
+	m_size.width	= 0;
+	m_size.height	= fm.height;
+	m_draw_spaces	= fm.draw_spaces;
+
+	calc_prefix_widths(ws);
+}
+
+int litehtml::el_text_run::render_inline(const ptr &container, int max_width)
+{
+	m_skip = false;
+	m_fragments.clear();
+	if(m_words.empty())
+	{
+		return 0;
+	}
+
+	white_space ws = get_white_space();
+	m_first_text_word	= -1;
+	m_last_text_word	= -1;
+	for(int i = 0; i < (int) m_words.size(); i++)
+	{
+		if(!is_white_space_word(m_words[i], ws))
+		{
+			if(m_first_text_word < 0)
+			{
+				m_first_text_word = i;
+			}
+			m_last_text_word = i;
+		}
+	}
+
+	return place_words(container, 0, (int) m_words.size() - 1, max_width, 0);
+}
+
+int litehtml::el_text_run::place_words(const element::ptr& container, int first, int last, int max_width, size_t insert_at)
+{
+	document::ptr doc = get_document();
+	white_space ws = get_white_space();
+	white_space container_ws = container->get_white_space();
+
+	int ret_width = 0;
+	int fragment_width = 0;
+	std::shared_ptr<el_text_fragment> fragment;
+
+	if(ws != m_prefix_ws || m_prefix_widths.size() != m_words.size() + 1)
+	{
+		calc_prefix_widths(ws);
+	}
+	bool wrap = container_ws != white_space_nowrap && container_ws != white_space_pre;
+	int_vector::const_iterator next_break = std::lower_bound(m_breaks.begin(), m_breaks.end(), first);
+
+	auto place = [&](int i)
+	{
+		auto el = std::make_shared<el_text_fragment>(this, i, doc);
+		m_fragments.insert(m_fragments.begin() + insert_at++, el);
+		int rw = container->place_element(el, max_width);
+		el->set_placed();
+		if(rw > ret_width)
+		{
+			ret_width = rw;
+		}
+		return std::make_pair(el, rw);
+	};
+
+	// collapsible space waiting for the next word, placed together with it
+	// when the word still fits into the current line
+	int space = -1;
+	bool was_space = false;
+
+	for(int i = first; i <= last; i++)
+	{
+		word& wrd = m_words[i];
+		wrd.skip = false;
+
+		bool is_break = is_break_word(wrd, ws);
+		if(is_white_space_word(wrd, ws))
+		{
+			if(was_space)
+			{
+				wrd.skip = true;
+				continue;
+			}
+			was_space = true;
+			if(!is_break)
+			{
+				space = i;
+				continue;
+			}
+		} else
+		{
+			was_space = false;
+		}
+
+		if(!is_break && fragment)
+		{
+			line_box* box = fragment->get_line_box();
+
+			// Take the words up to the next break that fit into the line at once.
+			// The last text word adds the inline shift and goes one by one, as does
+			// a space starting the call, which is not collapsed with the one before.
+			int start = space >= 0 ? space : i;
+			while(next_break != m_breaks.end() && *next_break < i)
+			{
+				next_break++;
+			}
+			int bulk_last = std::min(last, m_last_text_word - 1);
+			if(next_break != m_breaks.end())
+			{
+				bulk_last = std::min(bulk_last, *next_break - 1);
+			}
+			if(box && start > first && bulk_last > i)
+			{
+				int room = wrap ? box->free_width() : m_prefix_widths[bulk_last + 1] - m_prefix_widths[start];
+				int end = fit_words(start, i, bulk_last, room);
+				int width = m_prefix_widths[end + 1] - m_prefix_widths[start];
+				if(end > i && box->grow(fragment, width, container_ws))
+				{
+					for(int j = i + 1; j <= end; j++)
+					{
+						m_words[j].skip = is_collapsed_word(j, ws);
+					}
+					fragment->extend(end, width);
+					fragment_width += width;
+					if(fragment_width > ret_width)
+					{
+						ret_width = fragment_width;
+					}
+					space		= -1;
+					was_space	= false;
+					i			= end;
+					continue;
+				}
+			}
+
+			int width = wrd.width + (space >= 0 ? m_words[space].width : 0);
+			int shift = (i == m_last_text_word) ? get_inline_shift_right() : 0;
+			if(box && box->grow(fragment, width + shift, container_ws))
+			{
+				fragment->extend(i, width);
+				fragment_width += width;
+				if(fragment_width > ret_width)
+				{
+					ret_width = fragment_width;
+				}
+				space = -1;
+				continue;
+			}
+		}
+
+		if(space >= 0)
+		{
+			place(space);
+			space = -1;
+		}
+
+		auto placed = place(i);
+		if(is_break)
+		{
+			fragment = 0;
+		} else
+		{
+			fragment		= placed.first;
+			fragment_width	= placed.second;
+		}
+	}
+	if(space >= 0)
+	{
+		place(space);
+	}
+	return ret_width;
+}
+
+size_t litehtml::el_text_run::remove_fragment(const el_text_fragment* fragment)
+{
+	for(size_t i = 0; i < m_fragments.size(); i++)
+	{
+		if(m_fragments[i].get() == fragment)
+		{
+			m_fragments.erase(m_fragments.begin() + i);
+			return i;
+		}
+	}
+	return m_fragments.size();
+}
+
+void litehtml::el_text_run::draw(uint_ptr hdc, int x, int y, const position* clip)
+{
+	for(auto& fragment : m_fragments)
+	{
+		if(fragment->is_visible())
+		{
+			fragment->draw(hdc, x, y, clip);
+		}
+	}
+}
+
+void litehtml::el_text_run::calc_document_size(litehtml::size& sz, int x, int y)
+{
+	if(is_visible())
+	{
+		for(auto& fragment : m_fragments)
+		{
+			fragment->calc_document_size(sz, x, y);
+		}
+	}
+}
+
+void litehtml::el_text_run::get_redraw_box(litehtml::position& pos, int x, int y)
+{
+	if(is_visible())
+	{
+		for(auto& fragment : m_fragments)
+		{
+			fragment->get_redraw_box(pos, x, y);
+		}
+	}
+}
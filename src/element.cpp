@@ -9,6 +9,9 @@ litehtml::element::element(const std::shared_ptr<litehtml::document>& doc) : m_d
 {
 	m_box		= 0;
 	m_skip		= false;
+	m_layout_pending	= false;
+	m_layout_dirty				= layout_dirty_self | layout_dirty_children;
+	m_layout_dirty_generation	= 0;
 }
 
 litehtml::element::~element()
@@ -115,14 +118,14 @@ bool litehtml::element::get_predefined_height(int& p_height) const
 		{
 			position client_pos;
 			get_document()->container()->get_client_rect(client_pos);
-			p_height = h.calc_percent(client_pos.height);
+			p_height = get_document()->cvt_units(h, get_font_size(), client_pos.height);
 			return true;
 		} else
 		{
 			int ph = 0;
 			if (el_parent->get_predefined_height(ph))
 			{
-				p_height = h.calc_percent(ph);
+				p_height = get_document()->cvt_units(h, get_font_size(), ph);
 				if (is_body())
 				{
 					p_height -= content_margins_height();
@@ -178,7 +181,7 @@ int litehtml::element::calc_width(int defVal) const
 		{
 			position client_pos;
 			get_document()->container()->get_client_rect(client_pos);
-			return w.calc_percent(client_pos.width);
+			return get_document()->cvt_units(w, get_font_size(), client_pos.width);
 		} else
 		{
 			int pw = el_parent->calc_width(defVal);
@@ -186,7 +189,7 @@ int litehtml::element::calc_width(int defVal) const
 			{
 				pw -= content_margins_width();
 			}
-			return w.calc_percent(pw);
+			return get_document()->cvt_units(w, get_font_size(), pw);
 		}
 	}
 	return 	get_document()->cvt_units(w, get_font_size());
@@ -270,13 +273,14 @@ void litehtml::element::apply_relative_shift(int parent_width)
 	if (get_element_position(&offsets) == element_position_relative)
 	{
 		element::ptr parent_ptr = parent();
+		document::ptr doc = get_document();
 		if (!offsets.left.is_predefined())
 		{
-			m_pos.x += offsets.left.calc_percent(parent_width);
+			m_pos.x += doc->cvt_units(offsets.left, get_font_size(), parent_width);
 		}
 		else if (!offsets.right.is_predefined())
 		{
-			m_pos.x -= offsets.right.calc_percent(parent_width);
+			m_pos.x -= doc->cvt_units(offsets.right, get_font_size(), parent_width);
 		}
 		if (!offsets.top.is_predefined())
 		{
@@ -291,7 +295,7 @@ void litehtml::element::apply_relative_shift(int parent_width)
 				}
 			}
 
-			m_pos.y += offsets.top.calc_percent(h);
+			m_pos.y += doc->cvt_units(offsets.top, get_font_size(), h);
 		}
 		else if (!offsets.bottom.is_predefined())
 		{
@@ -306,11 +310,42 @@ void litehtml::element::apply_relative_shift(int parent_width)
 				}
 			}
 
-			m_pos.y -= offsets.bottom.calc_percent(h);
+			m_pos.y -= doc->cvt_units(offsets.bottom, get_font_size(), h);
 		}
 	}
 }
 
+int litehtml::element::measure(int max_width)
+{
+	return render(0, 0, max_width);
+}
+
+void litehtml::element::get_intrinsic_widths(int max_width, int& min_width, int& max_content_width)
+{
+	min_width			= measure(1);
+	max_content_width	= measure(max_width);
+}
+
+void litehtml::element::invalidate_layout()
+{
+	m_layout_dirty |= layout_dirty_self;
+
+	// The walk stops at an ancestor marked since the last render. Marks left by
+	// an earlier render (e.g. under display:none, which is never laid out) are
+	// not trusted, the generation tells them apart.
+	document::ptr doc = get_document();
+	unsigned int generation = doc ? doc->layout_generation() : 0;
+	for(element::ptr el = parent(); el; el = el->parent())
+	{
+		if((el->m_layout_dirty & layout_dirty_children) && el->m_layout_dirty_generation == generation)
+		{
+			break;
+		}
+		el->m_layout_dirty |= layout_dirty_children;
+		el->m_layout_dirty_generation = generation;
+	}
+}
+
 void litehtml::element::calc_auto_margins(int parent_width)							LITEHTML_EMPTY_FUNC
 const litehtml::background* litehtml::element::get_background(bool own_only)		LITEHTML_RETURN_FUNC(0)
 litehtml::element::ptr litehtml::element::get_element_by_point(int x, int y, int client_x, int client_y)	LITEHTML_RETURN_FUNC(0)
@@ -361,6 +396,8 @@ int litehtml::element::get_left_floats_height() const								LITEHTML_RETURN_FUN
 int litehtml::element::get_right_floats_height() const								LITEHTML_RETURN_FUNC(0)
 int litehtml::element::get_floats_height(element_float el_float) const				LITEHTML_RETURN_FUNC(0)
 bool litehtml::element::is_floats_holder() const									LITEHTML_RETURN_FUNC(false)
+bool litehtml::element::have_floats() const											LITEHTML_RETURN_FUNC(false)
+bool litehtml::element::is_width_dependent() const									LITEHTML_RETURN_FUNC(false)
 void litehtml::element::get_content_size( size& sz, int max_width )					LITEHTML_EMPTY_FUNC
 void litehtml::element::init()														LITEHTML_EMPTY_FUNC
 int litehtml::element::render( int x, int y, int max_width, bool second_pass )		LITEHTML_RETURN_FUNC(0)
@@ -381,6 +418,7 @@ const litehtml::tchar_t* litehtml::element::get_attr( const tchar_t* name, const
 bool litehtml::element::is_white_space() const										LITEHTML_RETURN_FUNC(false)
 bool litehtml::element::is_body() const												LITEHTML_RETURN_FUNC(false)
 bool litehtml::element::is_break() const											LITEHTML_RETURN_FUNC(false)
+bool litehtml::element::is_text_run() const										LITEHTML_RETURN_FUNC(false)
 int litehtml::element::get_base_line()												LITEHTML_RETURN_FUNC(0)
 bool litehtml::element::on_mouse_over()												LITEHTML_RETURN_FUNC(false)
 bool litehtml::element::on_mouse_leave()											LITEHTML_RETURN_FUNC(false)
@@ -401,6 +439,7 @@ const litehtml::tchar_t* litehtml::element::get_style_property( const tchar_t* n
 litehtml::uint_ptr litehtml::element::get_font( font_metrics* fm /*= 0*/ )			LITEHTML_RETURN_FUNC(0)
 int litehtml::element::get_font_size()	const										LITEHTML_RETURN_FUNC(0)
 void litehtml::element::get_text( tstring& text )									LITEHTML_EMPTY_FUNC
+void litehtml::element::apply_appended_stylesheet(const litehtml::css& stylesheet, const litehtml::css& master, const litehtml::css& author, elements_vector& changed) LITEHTML_EMPTY_FUNC
 void litehtml::element::parse_attributes()											LITEHTML_EMPTY_FUNC
 int litehtml::element::select( const css_selector& selector, bool apply_pseudo)		LITEHTML_RETURN_FUNC(select_no_match)
 int litehtml::element::select( const css_element_selector& selector, bool apply_pseudo /*= true*/ )	LITEHTML_RETURN_FUNC(select_no_match)
@@ -0,0 +1,103 @@
+#include "html.h"
+#include "float_bands.h"
+#include <algorithm>
+
+void litehtml::float_bands::clear()
+{
+	m_bands.clear();
+	m_valid = true;
+}
+
+void litehtml::float_bands::add_left(int top, int bottom, int right)
+{
+	int first	= split(top);
+	int last	= split(bottom);
+	for(int i = first; i < last; i++)
+	{
+		m_bands[i].left = std::max(m_bands[i].left, right);
+	}
+}
+
+void litehtml::float_bands::add_right(int top, int bottom, int left)
+{
+	int first	= split(top);
+	int last	= split(bottom);
+	for(int i = first; i < last; i++)
+	{
+		m_bands[i].right		= m_bands[i].has_right ? std::min(m_bands[i].right, left) : left;
+		m_bands[i].has_right	= true;
+	}
+}
+
+int litehtml::float_bands::line_left(int y) const
+{
+	int i = find(y);
+	return i >= 0 ? m_bands[i].left : 0;
+}
+
+int litehtml::float_bands::line_right(int y, int def_right) const
+{
+	int i = find(y);
+	if(i >= 0 && m_bands[i].has_right)
+	{
+		return std::min(m_bands[i].right, def_right);
+	}
+	return def_right;
+}
+
+int litehtml::float_bands::next_line_top(int top, int width, int def_right) const
+{
+	int i = find(top);
+	if(i < 0 || m_bands[i].top < top)
+	{
+		i++;
+	}
+	if(i >= (int) m_bands.size())
+	{
+		return top;
+	}
+	for(; i < (int) m_bands.size(); i++)
+	{
+		const band& b = m_bands[i];
+		int right = b.has_right ? std::min(b.right, def_right) : def_right;
+		if(right - b.left >= width)
+		{
+			return b.top;
+		}
+	}
+	return m_bands.back().top;
+}
+
+// Index of the band holding y, -1 above the first one
+int litehtml::float_bands::find(int y) const
+{
+	auto it = std::upper_bound(m_bands.begin(), m_bands.end(), y,
+		[](int val, const band& b)
+		{
+			return val < b.top;
+		});
+	return (int) (it - m_bands.begin()) - 1;
+}
+
+// Starts a band at y with the floats of the band it was part of
+int litehtml::float_bands::split(int y)
+{
+	int i = find(y);
+	if(i >= 0 && m_bands[i].top == y)
+	{
+		return i;
+	}
+	band b;
+	if(i >= 0)
+	{
+		b = m_bands[i];
+	} else
+	{
+		b.left		= 0;
+		b.right		= 0;
+		b.has_right	= false;
+	}
+	b.top = y;
+	m_bands.insert(m_bands.begin() + (i + 1), b);
+	return i + 1;
+}
@@ -0,0 +1,51 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Compile-time selection of the vector instructions used by the input
+// scanners in the tokenizer and the UTF-8 iterator.  GUMBO_SIMD_SSE2 and
+// GUMBO_SIMD_AVX2 are defined when the compiler targets them; every user keeps
+// a scalar loop for other targets and for the tail of the input.
+
+#ifndef GUMBO_SIMD_H_
+#define GUMBO_SIMD_H_
+
+#include <assert.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GUMBO_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define GUMBO_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(GUMBO_SIMD_SSE2) || defined(GUMBO_SIMD_AVX2)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit of a non-zero movemask result.
+static inline int gumbo_first_set_bit(unsigned int mask) {
+  assert(mask != 0);
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int) index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+#endif  // GUMBO_SIMD_H_
@@ -106,6 +106,16 @@ void gumbo_tokenizer_set_is_current_node_foreign(
 //   gumbo_tokenizer_state_destroy(&parser);
 bool gumbo_lex(struct GumboInternalParser* parser, GumboToken* output);
 
+// Fast path for the data state: if the input at the current position starts
+// with plain text (ASCII other than markup, character references, NUL, CR and
+// control characters), consumes the longest such run, fills output with it and
+// returns true.  The run is equivalent to the sequence of character and
+// whitespace tokens gumbo_lex would emit for it.  Returns false without
+// consuming anything when the tokenizer is not in a plain data state or no
+// plain text follows.
+bool gumbo_lex_text_run(
+    struct GumboInternalParser* parser, GumboStringPiece* output);
+
 // Frees the internally-allocated pointers within an GumboToken.  Note that this
 // doesn't free the token itself, since oftentimes it will be allocated on the
 // stack.  A simple call to free() (or GumboParser->deallocator, if
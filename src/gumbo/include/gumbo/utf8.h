@@ -87,6 +87,12 @@ void utf8iterator_init(struct GumboInternalParser* parser, const char* source,
 // Advances the current position by one code point.
 void utf8iterator_next(Utf8Iterator* iter);
 
+// Advances the current position past length bytes of ASCII text, as if
+// utf8iterator_next were called once per byte.  The caller must ensure the
+// bytes contain no carriage returns and no code points that are reported as
+// invalid, since neither is checked here.
+void utf8iterator_skip_ascii(Utf8Iterator* iter, size_t length);
+
 // Returns the current code point as an integer.
 int utf8iterator_current(const Utf8Iterator* iter);
 
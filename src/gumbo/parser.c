@@ -1128,6 +1128,43 @@ static void insert_text_token(GumboParser* parser, GumboToken* token) {
   gumbo_debug("Inserting text token '%c'.\n", token->v.character);
 }
 
+// Appends the plain text following a character token straight to the text
+// node buffer.  In the "in body" insertion mode with an HTML current node each
+// of those characters would be handled the same way as the token that was just
+// inserted (reconstructing the active formatting elements is a no-op after
+// it), so the whole run is taken from the tokenizer at once instead of one
+// token per character.
+static void maybe_insert_text_run(GumboParser* parser) {
+  GumboParserState* state = parser->_parser_state;
+  TextNodeBufferState* buffer_state = &state->_text_node;
+  if (state->_reprocess_current_token ||
+      state->_insertion_mode != GUMBO_INSERTION_MODE_IN_BODY ||
+      buffer_state->_buffer.length == 0) {
+    return;
+  }
+  const GumboNode* current_node = get_adjusted_current_node(parser);
+  if (!current_node ||
+      current_node->v.element.tag_namespace != GUMBO_NAMESPACE_HTML) {
+    return;
+  }
+  GumboStringPiece run;
+  if (!gumbo_lex_text_run(parser, &run)) {
+    return;
+  }
+  gumbo_string_buffer_append_string(parser, &run, &buffer_state->_buffer);
+  if (buffer_state->_type != GUMBO_NODE_TEXT || state->_frameset_ok) {
+    for (size_t i = 0; i < run.length; ++i) {
+      char c = run.data[i];
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\f') {
+        buffer_state->_type = GUMBO_NODE_TEXT;
+        set_frameset_not_ok(parser);
+        break;
+      }
+    }
+  }
+  gumbo_debug("Inserting text run '%.*s'.\n", (int) run.length, run.data);
+}
+
 // http://www.whatwg.org/specs/web-apps/current-work/complete/tokenization.html#generic-rcdata-element-parsing-algorithm
 static void run_generic_parsing_algorithm(
     GumboParser* parser, GumboToken* token, GumboTokenizerEnum lexer_state) {
@@ -4127,6 +4164,10 @@ GumboOutput* gumbo_parse_with_options(
             token.v.start_tag.is_self_closing);
 
     has_error = !handle_token(&parser, &token) || has_error;
+    if (token.type == GUMBO_TOKEN_CHARACTER ||
+        token.type == GUMBO_TOKEN_WHITESPACE) {
+      maybe_insert_text_run(&parser);
+    }
 
     // Check for memory leaks when ownership is transferred from start tag
     // tokens to nodes.
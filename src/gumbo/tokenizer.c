@@ -53,6 +53,7 @@
 #include "error.h"
 #include "gumbo.h"
 #include "parser.h"
+#include "simd.h"
 #include "string_buffer.h"
 #include "string_piece.h"
 #include "token_type.h"
@@ -2866,6 +2867,94 @@ bool gumbo_lex(GumboParser* parser, GumboToken* output) {
   }
 }
 
+// Plain text bytes are those the data state passes through unchanged as
+// character or whitespace tokens: printable ASCII other than '<' and '&', plus
+// tab, line feed and form feed.  Everything else (markup, character
+// references, NUL, CR, control characters and non-ASCII bytes) is left to the
+// regular per-character state machine, which handles newline normalization,
+// UTF-8 decoding and error reporting.
+static bool is_plain_text_byte(unsigned char c) {
+  if (c >= 0x20 && c < 0x7F) {
+    return c != '<' && c != '&';
+  }
+  return c == '\t' || c == '\n' || c == '\f';
+}
+
+// Returns a pointer to the first byte in [start, end) that is not plain text,
+// or end.  Scans 32 or 16 bytes at a time where the compiler targets AVX2 or
+// SSE2, with a bytewise loop for the tail and other targets.
+static const char* scan_plain_text(const char* start, const char* end) {
+  const char* c = start;
+#if defined(GUMBO_SIMD_AVX2)
+  const __m256i below_printable32 = _mm256_set1_epi8(0x1F);
+  const __m256i printable_end32 = _mm256_set1_epi8(0x7F);
+  while (end - c >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) c);
+    // Signed compares: bytes >= 0x80 are negative and fail the first test.
+    __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(v, below_printable32),
+        _mm256_cmpgt_epi8(printable_end32, v));
+    __m256i markup = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')));
+    __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\f'))));
+    __m256i plain =
+        _mm256_or_si256(_mm256_andnot_si256(markup, printable), space);
+    unsigned int special = ~(unsigned int) _mm256_movemask_epi8(plain);
+    if (special) {
+      return c + gumbo_first_set_bit(special);
+    }
+    c += 32;
+  }
+#endif
+#if defined(GUMBO_SIMD_SSE2)
+  const __m128i below_printable = _mm_set1_epi8(0x1F);
+  const __m128i printable_end = _mm_set1_epi8(0x7F);
+  while (end - c >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*) c);
+    __m128i printable = _mm_and_si128(
+        _mm_cmpgt_epi8(v, below_printable), _mm_cmplt_epi8(v, printable_end));
+    __m128i markup = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('<')),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('&')));
+    __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('\f'))));
+    __m128i plain = _mm_or_si128(_mm_andnot_si128(markup, printable), space);
+    unsigned int special = ~(unsigned int) _mm_movemask_epi8(plain) & 0xFFFF;
+    if (special) {
+      return c + gumbo_first_set_bit(special);
+    }
+    c += 16;
+  }
+#endif
+  while (c < end && is_plain_text_byte((unsigned char) *c)) {
+    ++c;
+  }
+  return c;
+}
+
+bool gumbo_lex_text_run(GumboParser* parser, GumboStringPiece* output) {
+  GumboTokenizerState* tokenizer = parser->_tokenizer_state;
+  if (tokenizer->_state != GUMBO_LEX_DATA || tokenizer->_is_in_cdata ||
+      tokenizer->_reconsume_current_input ||
+      tokenizer->_buffered_emit_char != kGumboNoChar ||
+      tokenizer->_temporary_buffer_emit) {
+    return false;
+  }
+  Utf8Iterator* input = &tokenizer->_input;
+  const char* start = utf8iterator_get_char_pointer(input);
+  const char* end =
+      scan_plain_text(start, utf8iterator_get_end_pointer(input));
+  if (end == start) {
+    return false;
+  }
+  utf8iterator_skip_ascii(input, end - start);
+  reset_token_start_point(tokenizer);
+  output->data = start;
+  output->length = end - start;
+  return true;
+}
+
 void gumbo_token_destroy(GumboParser* parser, GumboToken* token) {
   if (!token) return;
 
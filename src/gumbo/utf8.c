@@ -24,6 +24,7 @@
 #include "error.h"
 #include "gumbo.h"
 #include "parser.h"
+#include "simd.h"
 #include "util.h"
 #include "vector.h"
 
@@ -132,6 +133,15 @@ static void read_char(Utf8Iterator* iter) {
     return;
   }
 
+  // Printable ASCII is a complete, valid code point by itself and needs none of
+  // the handling below; it is most of the input in typical documents.
+  unsigned char first = (unsigned char) *iter->_start;
+  if (first >= 0x20 && first < 0x7F) {
+    iter->_current = first;
+    iter->_width = 1;
+    return;
+  }
+
   uint32_t code_point = 0;
   uint32_t state = UTF8_ACCEPT;
   for (const char* c = iter->_start; c < iter->_end; ++c) {
@@ -220,6 +230,41 @@ void utf8iterator_next(Utf8Iterator* iter) {
   read_char(iter);
 }
 
+void utf8iterator_skip_ascii(Utf8Iterator* iter, size_t length) {
+  const char* end = iter->_start + length;
+  assert(end <= iter->_end);
+  int tab_stop = iter->_parser->_options->tab_stop;
+  const char* c = iter->_start;
+#if defined(GUMBO_SIMD_SSE2)
+  // Blocks without line feeds or tabs only move the column.
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i tab = _mm_set1_epi8('\t');
+  while (end - c >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*) c);
+    if (_mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, tab)))) {
+      break;
+    }
+    iter->_pos.column += 16;
+    c += 16;
+  }
+#endif
+  for (; c < end; ++c) {
+    assert((unsigned char) *c < 0x80 && *c != '\r');
+    if (*c == '\n') {
+      ++iter->_pos.line;
+      iter->_pos.column = 1;
+    } else if (*c == '\t') {
+      iter->_pos.column = ((iter->_pos.column / tab_stop) + 1) * tab_stop;
+    } else {
+      ++iter->_pos.column;
+    }
+  }
+  iter->_pos.offset += length;
+  iter->_start = end;
+  read_char(iter);
+}
+
 int utf8iterator_current(const Utf8Iterator* iter) { return iter->_current; }
 
 void utf8iterator_get_position(
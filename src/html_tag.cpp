@@ -5,11 +5,51 @@
 #include "stylesheet.h"
 #include "table.h"
 #include <algorithm>
+#include <new>
 #include <locale>
+#include <type_traits>
 #include "el_before_after.h"
+#include "el_text_run.h"
 #include "num_cvt.h"
+#include "string_pool.h"
+#include "task_pool.h"
 
-litehtml::html_tag::html_tag(const std::shared_ptr<litehtml::document>& doc) : litehtml::element(doc)
+namespace
+{
+	// Calls fn(0) ... fn(count - 1) on the document's layout threads, or in order
+	// on this thread if the document has none
+	void run_layout_tasks(litehtml::task_pool* pool, int count, const std::function<void(int)>& fn)
+	{
+		if(pool)
+		{
+			pool->run(count, fn);
+		} else
+		{
+			for(int i = 0; i < count; i++)
+			{
+				fn(i);
+			}
+		}
+	}
+
+	// most elements have a box or two, the blocks grow for the ones with many
+	const size_t boxes_arena_block_size		= 128;
+	const size_t boxes_arena_max_block_size	= 16 * 1024;
+
+	// Constructs a box in the boxes arena of an element
+	template<class T, class... Args> T* construct_box(litehtml::arena& boxes_arena, Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "the boxes arena does not destroy its boxes");
+		void* mem = boxes_arena.allocate(sizeof(T));
+		if(!mem)
+		{
+			throw std::bad_alloc();
+		}
+		return new(mem) T(std::forward<Args>(args)...);
+	}
+}
+
+litehtml::html_tag::html_tag(const std::shared_ptr<litehtml::document>& doc) : litehtml::element(doc), m_boxes_arena(boxes_arena_block_size, boxes_arena_max_block_size)
 {
 	m_box_sizing			= box_sizing_content_box;
 	m_z_index				= 0;
@@ -32,6 +72,14 @@ litehtml::html_tag::html_tag(const std::shared_ptr<litehtml::document>& doc) : l
 	m_border_spacing_x		= 0;
 	m_border_spacing_y		= 0;
 	m_border_collapse		= border_collapse_separate;
+	m_vertical_align_shift	= 0;
+	m_layout_widths_next	= 0;
+	m_layout_cache_generation	= 0;
+	m_layout_stopped			= false;
+	m_layout_resumed			= false;
+	m_resume_child				= -1;
+	m_resume_ret_width			= 0;
+	m_children_size_count		= 0;
 }
 
 litehtml::html_tag::~html_tag()
@@ -45,6 +93,7 @@ bool litehtml::html_tag::appendChild(const element::ptr &el)
 	{
 		el->parent(shared_from_this());
 		m_children.push_back(el);
+		invalidate_layout();
 		return true;
 	}
 	return false;
@@ -56,6 +105,7 @@ bool litehtml::html_tag::removeChild(const element::ptr &el)
 	{
 		el->parent(nullptr);
 		m_children.erase(std::remove(m_children.begin(), m_children.end(), el), m_children.end());
+		invalidate_layout();
 		return true;
 	}
 	return false;
@@ -86,7 +136,26 @@ void litehtml::html_tag::set_attr( const tchar_t* name, const tchar_t* val )
 		{
 			s_val[i] = std::tolower(s_val[i], std::locale::classic());
 		}
-		m_attrs[s_val] = val;
+		bool pooled = false;
+		const tchar_t* attr_name = get_document()->attribute_name(s_val, pooled);
+
+		bool found = false;
+		for(auto& attr : m_attrs)
+		{
+			// a selector may have pooled the name after the attribute was set
+			if(attr.name == attr_name || (!attr.pooled && !t_strcmp(attr.name, attr_name)))
+			{
+				attr.name	= attr_name;
+				attr.pooled	= pooled;
+				attr.value	= val;
+				found = true;
+				break;
+			}
+		}
+		if(!found)
+		{
+			m_attrs.push_back(html_attribute(attr_name, val, pooled));
+		}
 
 		if( t_strcasecmp( name, _t("class") ) == 0 )
 		{
@@ -98,14 +167,29 @@ void litehtml::html_tag::set_attr( const tchar_t* name, const tchar_t* val )
 
 const litehtml::tchar_t* litehtml::html_tag::get_attr( const tchar_t* name, const tchar_t* def ) const
 {
-	string_map::const_iterator attr = m_attrs.find(name);
-	if(attr != m_attrs.end())
+	for(const auto& attr : m_attrs)
 	{
-		return attr->second.c_str();
+		if(attr.name == name || !t_strcmp(attr.name, name))
+		{
+			return attr.value.c_str();
+		}
 	}
 	return def;
 }
 
+const litehtml::tchar_t* litehtml::html_tag::get_pooled_attr( const tchar_t* pooled_name ) const
+{
+	for(const auto& attr : m_attrs)
+	{
+		// a selector may have pooled the name after the attribute was set
+		if(attr.name == pooled_name || (!attr.pooled && !t_strcmp(attr.name, pooled_name)))
+		{
+			return attr.value.c_str();
+		}
+	}
+	return 0;
+}
+
 litehtml::elements_vector litehtml::html_tag::select_all( const tstring& selector )
 {
 	css_selector sel(media_query_list::ptr(0));
@@ -233,6 +317,46 @@ void litehtml::html_tag::apply_stylesheet( const litehtml::css& stylesheet )
 	}
 }
 
+void litehtml::html_tag::apply_appended_stylesheet(const litehtml::css& stylesheet, const litehtml::css& master, const litehtml::css& author, elements_vector& changed)
+{
+	bool is_changed = false;
+	for(const auto& sel : stylesheet.selectors())
+	{
+		if(select(*sel, false) != select_no_match)
+		{
+			// keep m_used_styles in the cascade order: master stylesheet,
+			// document styles sorted by specificity, then user styles
+			used_selector::vector::iterator pos = m_used_styles.begin();
+			while(pos != m_used_styles.end() && master.contains((*pos)->m_selector))
+			{
+				pos++;
+			}
+			while(pos != m_used_styles.end() && author.contains((*pos)->m_selector) && *(*pos)->m_selector < *sel)
+			{
+				pos++;
+			}
+			m_used_styles.insert(pos, std::unique_ptr<used_selector>(new used_selector(sel, false)));
+			// selectors under inactive media are kept for a later media change only
+			if(sel->is_media_valid())
+			{
+				is_changed = true;
+			}
+		}
+	}
+	if(is_changed)
+	{
+		changed.push_back(shared_from_this());
+	}
+
+	for(auto& el : m_children)
+	{
+		if(el->get_display() != display_inline_text)
+		{
+			el->apply_appended_stylesheet(stylesheet, master, author, changed);
+		}
+	}
+}
+
 void litehtml::html_tag::get_content_size( size& sz, int max_width )
 {
 	sz.height	= 0;
@@ -261,7 +385,7 @@ void litehtml::html_tag::draw( uint_ptr hdc, int x, int y, const position* clip
 			border_box += m_padding;
 			border_box += m_borders;
 
-			border_radiuses bdr_radius = m_css_borders.radius.calc_percents(border_box.width, border_box.height);
+			border_radiuses bdr_radius = m_css_borders.radius.calc_percents(*get_document(), m_font_size, border_box.width, border_box.height);
 
 			bdr_radius -= m_borders;
 			bdr_radius -= m_padding;
@@ -309,6 +433,8 @@ const litehtml::tchar_t* litehtml::html_tag::get_style_property( const tchar_t*
 
 void litehtml::html_tag::parse_styles(bool is_reparse)
 {
+	invalidate_layout();
+
 	const tchar_t* style = get_attr(_t("style"));
 
 	if(style)
@@ -516,12 +642,322 @@ void litehtml::html_tag::parse_styles(bool is_reparse)
 
 int litehtml::html_tag::render( int x, int y, int max_width, bool second_pass )
 {
-	if (m_display == display_table || m_display == display_inline_table)
+	bool is_table = m_display == display_table || m_display == display_inline_table;
+	layout_key key = get_layout_key(max_width, second_pass);
+
+	if(m_layout_dirty)
+	{
+		// drop the results of the earlier layouts
+		m_layout_cache_generation++;
+	} else if(m_last_layout.valid && m_last_layout.key.matches(key))
+	{
+		// the boxes are the same relative to the element's origin
+		restore_last_layout(x, y);
+		return m_last_layout.ret_width;
+	}
+
+	// render_box() calls render() again for the second pass
+	m_last_layout.valid = false;
+	m_layout_stopped = false;
+	// a partial layout goes on where it stopped if nothing changed since
+	m_layout_resumed = m_resume_child >= 0 && !m_layout_dirty && m_resume_key.matches(key);
+	if(!m_layout_resumed)
+	{
+		m_children_size_count = 0;
+	}
+
+	int ret_width = is_table ? render_table(x, y, max_width, second_pass) : render_box(x, y, max_width, second_pass);
+
+	// the rest of the content is laid out when the layout goes on
+	if(m_layout_stopped)
+	{
+		m_resume_key	= key;
+		m_layout_dirty	= 0;
+		return ret_width;
+	}
+
+	// the element's own floats went to the floats holder
+	key.movable = key.movable && (is_table || is_floats_holder() || !have_floats());
+
+	m_last_layout.valid			= true;
+	m_last_layout.key			= key;
+	m_last_layout.ret_width		= ret_width;
+	m_last_layout.dx			= m_pos.x - x;
+	m_last_layout.dy			= m_pos.y - y;
+	m_last_layout.width			= m_pos.width;
+	m_last_layout.height		= m_pos.height;
+	m_last_layout.el_margins	= m_margins;
+	m_last_layout.el_padding	= m_padding;
+	m_last_layout.el_borders	= m_borders;
+	add_layout_width(key, ret_width);
+	m_layout_dirty = 0;
+
+	return ret_width;
+}
+
+int litehtml::html_tag::measure(int max_width)
+{
+	if(!m_layout_dirty)
+	{
+		layout_key key = get_layout_key(max_width, false);
+		for(const auto& lw : m_layout_widths)
+		{
+			if(lw.generation == m_layout_cache_generation && lw.key.matches(key))
+			{
+				// the element's size is the one of the layout its boxes are from, as
+				// the caller would have it after the layout
+				if(m_last_layout.valid)
+				{
+					restore_last_layout(0, 0);
+				}
+				return lw.ret_width;
+			}
+		}
+	}
+	return render(0, 0, max_width);
+}
+
+void litehtml::html_tag::get_intrinsic_widths(int max_width, int& min_width, int& max_content_width)
+{
+	bool restore = false;
+
+	// the content broken at every opportunity
+	layout_key key = get_layout_key(1, false);
+	if(!m_layout_dirty && m_min_content_width.generation == m_layout_cache_generation && m_min_content_width.key.matches(key))
+	{
+		min_width = m_min_content_width.ret_width;
+		restore = true;
+	} else
+	{
+		min_width = render(0, 0, 1);
+		if(m_last_layout.valid)
+		{
+			m_min_content_width.generation	= m_layout_cache_generation;
+			m_min_content_width.key			= m_last_layout.key;
+			m_min_content_width.ret_width	= min_width;
+		}
+	}
+
+	// Lines break only where the next item does not fit, so when nothing else in the
+	// subtree depends on the width, the content measured at some width lays out the
+	// same at any narrower width it still fits into.
+	key = get_layout_key(max_width, false);
+	const layout_width& mc = m_max_content_width;
+	if(!m_layout_dirty && mc.generation == m_layout_cache_generation &&
+		(mc.key.matches(key) ||
+		(mc.key.same_constraints(key) && max_width >= 1 && mc.ret_width <= max_width && max_width < mc.key.max_width && !is_width_dependent())))
+	{
+		max_content_width = mc.ret_width;
+		restore = true;
+	} else
+	{
+		max_content_width = render(0, 0, max_width);
+		if(m_last_layout.valid)
+		{
+			m_max_content_width.generation	= m_layout_cache_generation;
+			m_max_content_width.key			= m_last_layout.key;
+			m_max_content_width.ret_width	= max_content_width;
+		}
+		restore = false;
+	}
+
+	// the element's size is the one of the layout its boxes are from
+	if(restore && m_last_layout.valid)
+	{
+		restore_last_layout(0, 0);
+	}
+}
+
+void litehtml::html_tag::restore_last_layout(int x, int y)
+{
+	m_margins	= m_last_layout.el_margins;
+	m_padding	= m_last_layout.el_padding;
+	m_borders	= m_last_layout.el_borders;
+	m_pos.x			= x + m_last_layout.dx;
+	m_pos.y			= y + m_last_layout.dy;
+	m_pos.width		= m_last_layout.width;
+	m_pos.height	= m_last_layout.height;
+}
+
+const litehtml::float_bands& litehtml::html_tag::get_float_bands()
+{
+	if(!m_float_bands.is_valid())
+	{
+		m_float_bands.clear();
+		for(const auto& fb : m_floats_left)
+		{
+			m_float_bands.add_left(fb.pos.top(), fb.pos.bottom(), fb.pos.right());
+		}
+		for(const auto& fb : m_floats_right)
+		{
+			m_float_bands.add_right(fb.pos.top(), fb.pos.bottom(), fb.pos.left());
+		}
+	}
+	return m_float_bands;
+}
+
+litehtml::layout_key litehtml::html_tag::get_layout_key(int max_width, bool second_pass) const
+{
+	layout_key key;
+	key.max_width	= max_width;
+	key.second_pass	= second_pass;
+
+	element::ptr el_parent = parent();
+	if(el_parent)
+	{
+		if(!el_parent->get_predefined_height(key.parent_height))
+		{
+			key.parent_height = -1;
+		}
+	} else
 	{
-		return render_table(x, y, max_width, second_pass);
+		position client_pos;
+		get_document()->container()->get_client_rect(client_pos);
+		key.parent_height = client_pos.height;
 	}
 
-	return render_box(x, y, max_width, second_pass);
+	// other blocks add their floats to the floats holder and flow around its floats,
+	// their layout depends on the position only if the holder has any
+	key.movable = m_display == display_table || m_display == display_inline_table || is_floats_holder() || !have_floats();
+	key.fixed_width = is_fixed_width();
+	// the lengths of the element or of its content may be relative to the viewport
+	if(get_document()->uses_viewport_units())
+	{
+		key.viewport = get_document()->viewport_size();
+	}
+	return key;
+}
+
+// The used width is the element's own absolute width, so the layout is the same
+// at any max_width: its content is laid out in that width whatever the width of
+// the containing block is.
+bool litehtml::html_tag::is_fixed_width() const
+{
+	if(	m_display != display_block &&
+		m_display != display_list_item &&
+		m_display != display_inline_block &&
+		m_display != display_table &&
+		m_display != display_inline_table)
+	{
+		return false;
+	}
+	if(m_css_width.is_predefined() || m_float != float_none || m_el_position == element_position_absolute || m_el_position == element_position_fixed)
+	{
+		return false;
+	}
+	// auto margins center the element in the available width
+	if(m_css_margins.left.is_predefined() || m_css_margins.right.is_predefined())
+	{
+		return false;
+	}
+	return !has_relative_widths();
+}
+
+// The element and its ancestors are blocks of the normal flow, so the document
+// goes on below the element's content
+bool litehtml::html_tag::is_in_main_flow() const
+{
+	const element* el = this;
+	element::ptr el_parent;
+	while(el)
+	{
+		style_display display = el->get_display();
+		element_position position = el->get_element_position();
+		if(	(display != display_block && display != display_list_item) ||
+			(position != element_position_static && position != element_position_relative) ||
+			el->get_float() != float_none)
+		{
+			return false;
+		}
+		el_parent	= el->parent();
+		el			= el_parent.get();
+	}
+	return true;
+}
+
+// Hides the children from next_child on and tells the document the height they
+// would take, estimated from the children laid out before them. Without floats the
+// layout can go on later from the child in the last block box.
+void litehtml::html_tag::stop_layout(size_t next_child, int ret_width)
+{
+	m_layout_stopped	= true;
+	m_resume_child		= -1;
+	m_resume_ret_width	= ret_width;
+	if(!have_floats() && !m_boxes.empty() && m_boxes.back()->get_type() == box_block)
+	{
+		elements_vector els;
+		m_boxes.back()->get_elements(els);
+		for(int i = (int) next_child - 1; i >= 0; i--)
+		{
+			if(m_children[i] == els.front())
+			{
+				m_resume_child = i;
+				break;
+			}
+		}
+	}
+
+	int laid_out	= 0;
+	int pending		= 0;
+	for(size_t i = 0; i < m_children.size(); i++)
+	{
+		if(i >= next_child)
+		{
+			m_children[i]->set_layout_pending(true);
+		}
+		if(!m_children[i]->is_white_space())
+		{
+			(i < next_child ? laid_out : pending)++;
+		}
+	}
+	int height = m_boxes.empty() ? 0 : m_boxes.back()->bottom();
+	get_document()->stop_layout(laid_out ? (int) ((long long) height * pending / laid_out) : 0);
+}
+
+// Lengths resolved against the width or the height of the containing block, or
+// of the viewport
+bool litehtml::html_tag::has_relative_widths() const
+{
+	auto relative = [](const css_length& len)
+		{
+			if(len.is_predefined())
+			{
+				return false;
+			}
+			switch(len.units())
+			{
+			case css_units_percentage:
+			case css_units_vw:
+			case css_units_vh:
+			case css_units_vmin:
+			case css_units_vmax:
+				return true;
+			default:
+				return len.calc_terms() != nullptr;
+			}
+		};
+	return	relative(m_css_width)			|| relative(m_css_min_width)		|| relative(m_css_max_width)		||
+			relative(m_css_height)			|| relative(m_css_min_height)		|| relative(m_css_max_height)		||
+			relative(m_css_margins.left)	|| relative(m_css_margins.right)	|| relative(m_css_margins.top)		|| relative(m_css_margins.bottom)	||
+			relative(m_css_padding.left)	|| relative(m_css_padding.right)	|| relative(m_css_padding.top)		|| relative(m_css_padding.bottom)	||
+			relative(m_css_offsets.left)	|| relative(m_css_offsets.right)	|| relative(m_css_text_indent);
+}
+
+void litehtml::html_tag::add_layout_width(const layout_key& key, int ret_width)
+{
+	for(auto& lw : m_layout_widths)
+	{
+		if(lw.generation == m_layout_cache_generation && lw.key.matches(key))
+		{
+			lw.ret_width = ret_width;
+			return;
+		}
+	}
+	layout_width& lw = m_layout_widths[m_layout_widths_next];
+	m_layout_widths_next = (m_layout_widths_next + 1) % (int) (sizeof(m_layout_widths) / sizeof(m_layout_widths[0]));
+	lw.generation	= m_layout_cache_generation;
+	lw.key			= key;
+	lw.ret_width	= ret_width;
 }
 
 bool litehtml::html_tag::is_white_space() const
@@ -693,7 +1129,7 @@ int litehtml::html_tag::select(const css_element_selector& selector, bool apply_
 
 	for(css_attribute_selector::vector::const_iterator i = selector.m_attrs.begin(); i != selector.m_attrs.end(); i++)
 	{
-		const tchar_t* attr_value = get_attr(i->attribute.c_str());
+		const tchar_t* attr_value = get_pooled_attr(i->pooled_attribute);
 		switch(i->condition)
 		{
 		case select_exists:
@@ -1091,25 +1527,7 @@ int litehtml::html_tag::get_line_left( int y )
 {
 	if(is_floats_holder())
 	{
-		if(m_cahe_line_left.is_valid && m_cahe_line_left.hash == y)
-		{
-			return m_cahe_line_left.val;
-		}
-
-		int w = 0;
-		for(const auto& fb : m_floats_left)
-		{
-			if (y >= fb.pos.top() && y < fb.pos.bottom())
-			{
-				w = std::max(w, fb.pos.right());
-				if (w < fb.pos.right())
-				{
-					break;
-				}
-			}
-		}
-		m_cahe_line_left.set_value(y, w);
-		return w;
+		return get_float_bands().line_left(y);
 	}
 	element::ptr el_parent = parent();
 	if (el_parent)
@@ -1128,33 +1546,7 @@ int litehtml::html_tag::get_line_right( int y, int def_right )
 {
 	if(is_floats_holder())
 	{
-		if(m_cahe_line_right.is_valid && m_cahe_line_right.hash == y)
-		{
-			if(m_cahe_line_right.is_default)
-			{
-				return def_right;
-			} else
-			{
-				return std::min(m_cahe_line_right.val, def_right);
-			}
-		}
-
-		int w = def_right;
-		m_cahe_line_right.is_default = true;
-		for(const auto& fb : m_floats_right)
-		{
-			if(y >= fb.pos.top() && y < fb.pos.bottom())
-			{
-				w = std::min(w, fb.pos.left());
-				m_cahe_line_right.is_default = false;
-				if(w > fb.pos.left())
-				{
-					break;
-				}
-			}
-		}
-		m_cahe_line_right.set_value(y, w);
-		return w;
+		return get_float_bands().line_right(y, def_right);
 	}
 	element::ptr el_parent = parent();
 	if (el_parent)
@@ -1220,7 +1612,7 @@ int litehtml::html_tag::fix_line_width( int max_width, element_float flt )
 
 		if(!was_cleared)
 		{
-			m_boxes.pop_back();
+			pop_box();
 
 			for(elements_vector::iterator i = els.begin(); i != els.end(); i++)
 			{
@@ -1266,7 +1658,7 @@ int litehtml::html_tag::fix_line_width( int max_width, element_float flt )
 					}
 					if(!line_box_found)
 					{
-						line_left += m_css_text_indent.calc_percent(max_width);
+						line_left += get_document()->cvt_units(m_css_text_indent, m_font_size, max_width);
 					}
 				}
 
@@ -1303,6 +1695,10 @@ void litehtml::html_tag::add_float(const element::ptr &el, int x, int y)
 
 		if(fb.float_side == float_left)
 		{
+			if(m_float_bands.is_valid())
+			{
+				m_float_bands.add_left(fb.pos.top(), fb.pos.bottom(), fb.pos.right());
+			}
 			if(m_floats_left.empty())
 			{
 				m_floats_left.push_back(fb);
@@ -1323,9 +1719,12 @@ void litehtml::html_tag::add_float(const element::ptr &el, int x, int y)
 					m_floats_left.push_back(std::move(fb));
 				}
 			}
-			m_cahe_line_left.invalidate();
 		} else if(fb.float_side == float_right)
 		{
+			if(m_float_bands.is_valid())
+			{
+				m_float_bands.add_right(fb.pos.top(), fb.pos.bottom(), fb.pos.left());
+			}
 			if(m_floats_right.empty())
 			{
 				m_floats_right.push_back(std::move(fb));
@@ -1346,7 +1745,6 @@ void litehtml::html_tag::add_float(const element::ptr &el, int x, int y)
 					m_floats_right.push_back(fb);
 				}
 			}
-			m_cahe_line_right.invalidate();
 		}
 	} else
 	{
@@ -1358,68 +1756,60 @@ void litehtml::html_tag::add_float(const element::ptr &el, int x, int y)
 	}
 }
 
-int litehtml::html_tag::find_next_line_top( int top, int width, int def_right )
+bool litehtml::html_tag::have_floats() const
 {
 	if(is_floats_holder())
 	{
-		int new_top = top;
-		int_vector points;
+		return !m_floats_left.empty() || !m_floats_right.empty();
+	}
+	element::ptr el_parent = parent();
+	if (el_parent)
+	{
+		return el_parent->have_floats();
+	}
+	return false;
+}
 
-		for(const auto& fb : m_floats_left)
-		{
-			if(fb.pos.top() >= top)
-			{
-				if(find(points.begin(), points.end(), fb.pos.top()) == points.end())
-				{
-					points.push_back(fb.pos.top());
-				}
-			}
-			if (fb.pos.bottom() >= top)
-			{
-				if (find(points.begin(), points.end(), fb.pos.bottom()) == points.end())
-				{
-					points.push_back(fb.pos.bottom());
-				}
-			}
-		}
+bool litehtml::html_tag::is_width_dependent() const
+{
+	if(m_display == display_none)
+	{
+		return false;
+	}
+	if(m_float != float_none || m_el_position == element_position_absolute || m_el_position == element_position_fixed)
+	{
+		return true;
+	}
+	// auto margins center blocks and tables in the available width
+	if(m_css_margins.left.is_predefined() || m_css_margins.right.is_predefined())
+	{
+		return true;
+	}
+	if(has_relative_widths())
+	{
+		return true;
+	}
+	// the content is laid out in the element's own width
+	if(is_fixed_width())
+	{
+		return false;
+	}
 
-		for (const auto& fb : m_floats_right)
+	for(const auto& el : m_children)
+	{
+		if(el->is_width_dependent())
 		{
-			if (fb.pos.top() >= top)
-			{
-				if (find(points.begin(), points.end(), fb.pos.top()) == points.end())
-				{
-					points.push_back(fb.pos.top());
-				}
-			}
-			if (fb.pos.bottom() >= top)
-			{
-				if (find(points.begin(), points.end(), fb.pos.bottom()) == points.end())
-				{
-					points.push_back(fb.pos.bottom());
-				}
-			}
+			return true;
 		}
+	}
+	return false;
+}
 
-		if(!points.empty())
-		{
-			sort(points.begin(), points.end(), std::less<int>( ));
-			new_top = points.back();
-
-			for(auto pt : points)
-			{
-				int pos_left	= 0;
-				int pos_right	= def_right;
-				get_line_left_right(pt, def_right, pos_left, pos_right);
-
-				if(pos_right - pos_left >= width)
-				{
-					new_top = pt;
-					break;
-				}
-			}
-		}
-		return new_top;
+int litehtml::html_tag::find_next_line_top( int top, int width, int def_right )
+{
+	if(is_floats_holder())
+	{
+		return get_float_bands().next_line_top(top, width, def_right);
 	}
 	element::ptr el_parent = parent();
 	if (el_parent)
@@ -1604,20 +1994,22 @@ void litehtml::html_tag::add_positioned(const element::ptr &el)
 
 void litehtml::html_tag::calc_outlines( int parent_width )
 {
-	m_padding.left	= m_css_padding.left.calc_percent(parent_width);
-	m_padding.right	= m_css_padding.right.calc_percent(parent_width);
+	document::ptr doc = get_document();
 
-	m_borders.left	= m_css_borders.left.width.calc_percent(parent_width);
-	m_borders.right	= m_css_borders.right.width.calc_percent(parent_width);
+	m_padding.left	= doc->cvt_units(m_css_padding.left, m_font_size, parent_width);
+	m_padding.right	= doc->cvt_units(m_css_padding.right, m_font_size, parent_width);
 
-	m_margins.left	= m_css_margins.left.calc_percent(parent_width);
-	m_margins.right	= m_css_margins.right.calc_percent(parent_width);
+	m_borders.left	= doc->cvt_units(m_css_borders.left.width, m_font_size, parent_width);
+	m_borders.right	= doc->cvt_units(m_css_borders.right.width, m_font_size, parent_width);
 
-	m_margins.top		= m_css_margins.top.calc_percent(parent_width);
-	m_margins.bottom	= m_css_margins.bottom.calc_percent(parent_width);
+	m_margins.left	= doc->cvt_units(m_css_margins.left, m_font_size, parent_width);
+	m_margins.right	= doc->cvt_units(m_css_margins.right, m_font_size, parent_width);
 
-	m_padding.top		= m_css_padding.top.calc_percent(parent_width);
-	m_padding.bottom	= m_css_padding.bottom.calc_percent(parent_width);
+	m_margins.top		= doc->cvt_units(m_css_margins.top, m_font_size, parent_width);
+	m_margins.bottom	= doc->cvt_units(m_css_margins.bottom, m_font_size, parent_width);
+
+	m_padding.top		= doc->cvt_units(m_css_padding.top, m_font_size, parent_width);
+	m_padding.bottom	= doc->cvt_units(m_css_padding.bottom, m_font_size, parent_width);
 }
 
 void litehtml::html_tag::calc_auto_margins(int parent_width)
@@ -1683,7 +2075,7 @@ void litehtml::html_tag::get_inline_boxes( position::vector& boxes )
 {
 	litehtml::box* old_box = 0;
 	position pos;
-	for(auto& el : m_children)
+	auto add_box = [&](const element::ptr& el)
 	{
 		if(!el->skip())
 		{
@@ -1732,6 +2124,22 @@ void litehtml::html_tag::get_inline_boxes( position::vector& boxes )
 				}
 			}
 		}
+	};
+	for(auto& el : m_children)
+	{
+		if(el->is_text_run())
+		{
+			if(!el->skip())
+			{
+				for(auto& fragment : std::static_pointer_cast<el_text_run>(el)->get_fragments())
+				{
+					add_box(fragment);
+				}
+			}
+		} else
+		{
+			add_box(el);
+		}
 	}
 	if(pos.width || pos.height)
 	{
@@ -1996,7 +2404,7 @@ void litehtml::html_tag::init_font()
 		{
 			if(sz.units() == css_units_percentage)
 			{
-				m_font_size = sz.calc_percent(parent_sz);
+				m_font_size = get_document()->cvt_units(sz, parent_sz, parent_sz);
 			} else if(sz.units() == css_units_none)
 			{
 				m_font_size = parent_sz;
@@ -2058,7 +2466,7 @@ void litehtml::html_tag::draw_background( uint_ptr hdc, int x, int y, const posi
 			border_box += m_borders;
 
 			borders bdr = m_css_borders;
-			bdr.radius = m_css_borders.radius.calc_percents(border_box.width, border_box.height);
+			bdr.radius = m_css_borders.radius.calc_percents(*get_document(), m_font_size, border_box.width, border_box.height);
 
 			get_document()->container()->draw_borders(hdc, bdr, border_box, have_parent() ? false : true);
 		}
@@ -2123,11 +2531,11 @@ void litehtml::html_tag::draw_background( uint_ptr hdc, int x, int y, const posi
 
 				if(bg)
 				{
-					bg_paint.border_radius = bdr.radius.calc_percents(bg_paint.border_box.width, bg_paint.border_box.width);
+					bg_paint.border_radius = bdr.radius.calc_percents(*get_document(), m_font_size, bg_paint.border_box.width, bg_paint.border_box.width);
 					get_document()->container()->draw_background(hdc, bg_paint);
 				}
 				borders b = bdr;
-				b.radius = bdr.radius.calc_percents(box->width, box->height);
+				b.radius = bdr.radius.calc_percents(*get_document(), m_font_size, box->width, box->height);
 				get_document()->container()->draw_borders(hdc, b, *box, false);
 			}
 		}
@@ -2185,6 +2593,11 @@ int litehtml::html_tag::place_element(const element::ptr &el, int max_width)
 {
 	if(el->get_display() == display_none) return 0;
 
+	if(el->is_text_run())
+	{
+		return el->render_inline(shared_from_this(), max_width);
+	}
+
 	if(el->get_display() == display_inline)
 	{
 		return el->render_inline(shared_from_this(), max_width);
@@ -2319,8 +2732,10 @@ int litehtml::html_tag::place_element(const element::ptr &el, int max_width)
 				if(el->is_replaced() || el->is_floats_holder())
 				{
 					element::ptr el_parent = el->parent();
-					el->m_pos.width = el->get_css_width().calc_percent(line_ctx.right - line_ctx.left);
-					el->m_pos.height = el->get_css_height().calc_percent(el_parent ? el_parent->m_pos.height : 0);
+					css_length el_w = el->get_css_width();
+					css_length el_h = el->get_css_height();
+					el->m_pos.width = get_document()->cvt_units(el_w, el->get_font_size(), line_ctx.right - line_ctx.left);
+					el->m_pos.height = get_document()->cvt_units(el_h, el->get_font_size(), el_parent ? el_parent->m_pos.height : 0);
 				}
 				el->calc_outlines(line_ctx.right - line_ctx.left);
 				break;
@@ -2518,7 +2933,7 @@ int litehtml::html_tag::finish_last_box(bool end_of_render)
 		if(m_boxes.back()->is_empty())
 		{
 			line_top = m_boxes.back()->top();
-			m_boxes.pop_back();
+			pop_box();
 		}
 
 		if(!m_boxes.empty())
@@ -2529,6 +2944,16 @@ int litehtml::html_tag::finish_last_box(bool end_of_render)
 	return line_top;
 }
 
+// Drops the last box, the items of a line box are taken off the end of m_line_items
+void litehtml::html_tag::pop_box()
+{
+	if(m_boxes.back()->get_type() == box_line)
+	{
+		m_line_items.resize(static_cast<line_box*>(m_boxes.back())->first_item());
+	}
+	m_boxes.pop_back();
+}
+
 int litehtml::html_tag::new_box(const element::ptr &el, int max_width, line_context& line_ctx)
 {
 	line_ctx.top = get_cleared_top(el, finish_last_box());
@@ -2573,16 +2998,16 @@ int litehtml::html_tag::new_box(const element::ptr &el, int max_width, line_cont
 			}
 			if(!line_box_found)
 			{
-				text_indent = m_css_text_indent.calc_percent(max_width);
+				text_indent = get_document()->cvt_units(m_css_text_indent, m_font_size, max_width);
 			}
 		}
 
 		font_metrics fm;
 		get_font(&fm);
-		m_boxes.emplace_back(std::unique_ptr<line_box>(new line_box(line_ctx.top, line_ctx.left + first_line_margin + text_indent, line_ctx.right, line_height(), fm, m_text_align)));
+		m_boxes.push_back(construct_box<line_box>(m_boxes_arena, line_ctx.top, line_ctx.left + first_line_margin + text_indent, line_ctx.right, line_height(), fm, m_text_align, m_line_items));
 	} else
 	{
-		m_boxes.emplace_back(std::unique_ptr<block_box>(new block_box(line_ctx.top, line_ctx.left, line_ctx.right)));
+		m_boxes.push_back(construct_box<block_box>(m_boxes_arena, line_ctx.top, line_ctx.left, line_ctx.right));
 	}
 
 	return line_ctx.top;
@@ -2785,8 +3210,10 @@ void litehtml::html_tag::apply_vertical_align()
 {
 	if(!m_boxes.empty())
 	{
+		// the boxes may be shifted already when the element is aligned again
+		// after its layout was reused
 		int add = 0;
-		int content_height	= m_boxes.back()->bottom();
+		int content_height	= m_boxes.back()->bottom() - m_vertical_align_shift;
 
 		if(m_pos.height > content_height)
 		{
@@ -2804,12 +3231,13 @@ void litehtml::html_tag::apply_vertical_align()
 			}
 		}
 
-		if(add)
+		if(add != m_vertical_align_shift)
 		{
 			for(size_t i = 0; i < m_boxes.size(); i++)
 			{
-				m_boxes[i]->y_shift(add);
+				m_boxes[i]->y_shift(add - m_vertical_align_shift);
 			}
+			m_vertical_align_shift = add;
 		}
 	}
 }
@@ -2828,6 +3256,7 @@ void litehtml::html_tag::init_background_paint(position pos, background_paint &b
 	if(!bg) return;
 
 	bg_paint = *bg;
+	css_position bg_pos = bg->m_position;
 	position content_box	= pos;
 	position padding_box	= pos;
 	padding_box += m_padding;
@@ -2870,9 +3299,9 @@ void litehtml::html_tag::init_background_paint(position pos, background_paint &b
 			double img_ar_height	= (double) bg_paint.image_size.height / (double) bg_paint.image_size.width;
 
 
-			if(bg->m_position.width.is_predefined())
+			if(bg_pos.width.is_predefined())
 			{
-				switch(bg->m_position.width.predef())
+				switch(bg_pos.width.predef())
 				{
 				case litehtml::background_size_contain:
 					if( (int) ((double) bg_paint.origin_box.width * img_ar_height) <= bg_paint.origin_box.height )
@@ -2898,32 +3327,32 @@ void litehtml::html_tag::init_background_paint(position pos, background_paint &b
 					break;
 					break;
 				case litehtml::background_size_auto:
-					if(!bg->m_position.height.is_predefined())
+					if(!bg_pos.height.is_predefined())
 					{
-						img_new_sz.height	= bg->m_position.height.calc_percent(bg_paint.origin_box.height);
+						img_new_sz.height	= get_document()->cvt_units(bg_pos.height, m_font_size, bg_paint.origin_box.height);
 						img_new_sz.width	= (int) ((double) img_new_sz.height * img_ar_width);
 					}
 					break;
 				}
 			} else
 			{
-				img_new_sz.width = bg->m_position.width.calc_percent(bg_paint.origin_box.width);
-				if(bg->m_position.height.is_predefined())
+				img_new_sz.width = get_document()->cvt_units(bg_pos.width, m_font_size, bg_paint.origin_box.width);
+				if(bg_pos.height.is_predefined())
 				{
 					img_new_sz.height = (int) ((double) img_new_sz.width * img_ar_height);
 				} else
 				{
-					img_new_sz.height = bg->m_position.height.calc_percent(bg_paint.origin_box.height);
+					img_new_sz.height = get_document()->cvt_units(bg_pos.height, m_font_size, bg_paint.origin_box.height);
 				}
 			}
 
 			bg_paint.image_size = img_new_sz;
-			bg_paint.position_x = bg_paint.origin_box.x + (int) bg->m_position.x.calc_percent(bg_paint.origin_box.width - bg_paint.image_size.width);
-			bg_paint.position_y = bg_paint.origin_box.y + (int) bg->m_position.y.calc_percent(bg_paint.origin_box.height - bg_paint.image_size.height);
+			bg_paint.position_x = bg_paint.origin_box.x + (int) get_document()->cvt_units(bg_pos.x, m_font_size, bg_paint.origin_box.width - bg_paint.image_size.width);
+			bg_paint.position_y = bg_paint.origin_box.y + (int) get_document()->cvt_units(bg_pos.y, m_font_size, bg_paint.origin_box.height - bg_paint.image_size.height);
 		}
 
 	}
-	bg_paint.border_radius	= m_css_borders.radius.calc_percents(border_box.width, border_box.height);;
+	bg_paint.border_radius	= m_css_borders.radius.calc_percents(*get_document(), m_font_size, border_box.width, border_box.height);;
 	bg_paint.border_box		= border_box;
 	bg_paint.is_root		= have_parent() ? false : true;
 }
@@ -3089,6 +3518,10 @@ bool litehtml::html_tag::fetch_positioned()
 
 	for(auto& el : m_children)
 	{
+		if(el->is_layout_pending())
+		{
+			continue;
+		}
 		el_pos = el->get_element_position();
 		if (el_pos != element_position_static)
 		{
@@ -3113,8 +3546,9 @@ int litehtml::html_tag::get_zindex() const
 
 void litehtml::html_tag::render_positioned(render_type rt)
 {
+	document::ptr doc = get_document();
 	position wnd_position;
-	get_document()->container()->get_client_rect(wnd_position);
+	doc->container()->get_client_rect(wnd_position);
 
 	element_position el_position;
 	bool process;
@@ -3176,7 +3610,7 @@ void litehtml::html_tag::render_positioned(render_type rt)
             int new_height = -1;
 			if(el_w.units() == css_units_percentage && parent_width)
 			{
-                new_width = el_w.calc_percent(parent_width);
+                new_width = doc->cvt_units(el_w, el->get_font_size(), parent_width);
                 if(el->m_pos.width != new_width)
 				{
 					need_render = true;
@@ -3186,7 +3620,7 @@ void litehtml::html_tag::render_positioned(render_type rt)
 
 			if(el_h.units() == css_units_percentage && parent_height)
 			{
-                new_height = el_h.calc_percent(parent_height);
+                new_height = doc->cvt_units(el_h, el->get_font_size(), parent_height);
                 if(el->m_pos.height != new_height)
 				{
 					need_render = true;
@@ -3203,14 +3637,14 @@ void litehtml::html_tag::render_positioned(render_type rt)
 				{
 					if(!css_left.is_predefined() && css_right.is_predefined())
 					{
-						el->m_pos.x = css_left.calc_percent(parent_width) + el->content_margins_left();
+						el->m_pos.x = doc->cvt_units(css_left, el->get_font_size(), parent_width) + el->content_margins_left();
 					} else if(css_left.is_predefined() && !css_right.is_predefined())
 					{
-						el->m_pos.x = parent_width - css_right.calc_percent(parent_width) - el->m_pos.width - el->content_margins_right();
+						el->m_pos.x = parent_width - doc->cvt_units(css_right, el->get_font_size(), parent_width) - el->m_pos.width - el->content_margins_right();
 					} else
 					{
-						el->m_pos.x		= css_left.calc_percent(parent_width) + el->content_margins_left();
-						el->m_pos.width	= parent_width - css_left.calc_percent(parent_width) - css_right.calc_percent(parent_width) - (el->content_margins_left() + el->content_margins_right());
+						el->m_pos.x		= doc->cvt_units(css_left, el->get_font_size(), parent_width) + el->content_margins_left();
+						el->m_pos.width	= parent_width - doc->cvt_units(css_left, el->get_font_size(), parent_width) - doc->cvt_units(css_right, el->get_font_size(), parent_width) - (el->content_margins_left() + el->content_margins_right());
 						need_render = true;
 					}
 				}
@@ -3219,14 +3653,14 @@ void litehtml::html_tag::render_positioned(render_type rt)
 				{
 					if(!css_top.is_predefined() && css_bottom.is_predefined())
 					{
-						el->m_pos.y = css_top.calc_percent(parent_height) + el->content_margins_top();
+						el->m_pos.y = doc->cvt_units(css_top, el->get_font_size(), parent_height) + el->content_margins_top();
 					} else if(css_top.is_predefined() && !css_bottom.is_predefined())
 					{
-						el->m_pos.y = parent_height - css_bottom.calc_percent(parent_height) - el->m_pos.height - el->content_margins_bottom();
+						el->m_pos.y = parent_height - doc->cvt_units(css_bottom, el->get_font_size(), parent_height) - el->m_pos.height - el->content_margins_bottom();
 					} else
 					{
-						el->m_pos.y			= css_top.calc_percent(parent_height) + el->content_margins_top();
-						el->m_pos.height	= parent_height - css_top.calc_percent(parent_height) - css_bottom.calc_percent(parent_height) - (el->content_margins_top() + el->content_margins_bottom());
+						el->m_pos.y			= doc->cvt_units(css_top, el->get_font_size(), parent_height) + el->content_margins_top();
+						el->m_pos.height	= parent_height - doc->cvt_units(css_top, el->get_font_size(), parent_height) - doc->cvt_units(css_bottom, el->get_font_size(), parent_height) - (el->content_margins_top() + el->content_margins_bottom());
 						need_render = true;
 					}
 				}
@@ -3236,14 +3670,14 @@ void litehtml::html_tag::render_positioned(render_type rt)
 				{
 					if(!css_left.is_predefined() && css_right.is_predefined())
 					{
-						el->m_pos.x = css_left.calc_percent(parent_width) + el->content_margins_left() - m_padding.left;
+						el->m_pos.x = doc->cvt_units(css_left, el->get_font_size(), parent_width) + el->content_margins_left() - m_padding.left;
 					} else if(css_left.is_predefined() && !css_right.is_predefined())
 					{
-						el->m_pos.x = m_pos.width + m_padding.right - css_right.calc_percent(parent_width) - el->m_pos.width - el->content_margins_right();
+						el->m_pos.x = m_pos.width + m_padding.right - doc->cvt_units(css_right, el->get_font_size(), parent_width) - el->m_pos.width - el->content_margins_right();
 					} else
 					{
-						el->m_pos.x		= css_left.calc_percent(parent_width) + el->content_margins_left() - m_padding.left;
-						el->m_pos.width	= m_pos.width + m_padding.left + m_padding.right - css_left.calc_percent(parent_width) - css_right.calc_percent(parent_width) - (el->content_margins_left() + el->content_margins_right());
+						el->m_pos.x		= doc->cvt_units(css_left, el->get_font_size(), parent_width) + el->content_margins_left() - m_padding.left;
+						el->m_pos.width	= m_pos.width + m_padding.left + m_padding.right - doc->cvt_units(css_left, el->get_font_size(), parent_width) - doc->cvt_units(css_right, el->get_font_size(), parent_width) - (el->content_margins_left() + el->content_margins_right());
                         if (new_width != -1)
                         {
                             el->m_pos.x += (el->m_pos.width - new_width) / 2;
@@ -3258,14 +3692,14 @@ void litehtml::html_tag::render_positioned(render_type rt)
 				{
 					if(!css_top.is_predefined() && css_bottom.is_predefined())
 					{
-						el->m_pos.y = css_top.calc_percent(parent_height) + el->content_margins_top() - m_padding.top;
+						el->m_pos.y = doc->cvt_units(css_top, el->get_font_size(), parent_height) + el->content_margins_top() - m_padding.top;
 					} else if(css_top.is_predefined() && !css_bottom.is_predefined())
 					{
-						el->m_pos.y = m_pos.height + m_padding.bottom - css_bottom.calc_percent(parent_height) - el->m_pos.height - el->content_margins_bottom();
+						el->m_pos.y = m_pos.height + m_padding.bottom - doc->cvt_units(css_bottom, el->get_font_size(), parent_height) - el->m_pos.height - el->content_margins_bottom();
 					} else
 					{
-						el->m_pos.y			= css_top.calc_percent(parent_height) + el->content_margins_top() - m_padding.top;
-						el->m_pos.height	= m_pos.height + m_padding.top + m_padding.bottom - css_top.calc_percent(parent_height) - css_bottom.calc_percent(parent_height) - (el->content_margins_top() + el->content_margins_bottom());
+						el->m_pos.y			= doc->cvt_units(css_top, el->get_font_size(), parent_height) + el->content_margins_top() - m_padding.top;
+						el->m_pos.height	= m_pos.height + m_padding.top + m_padding.bottom - doc->cvt_units(css_top, el->get_font_size(), parent_height) - doc->cvt_units(css_bottom, el->get_font_size(), parent_height) - (el->content_margins_top() + el->content_margins_bottom());
                         if (new_height != -1)
                         {
                             el->m_pos.y += (el->m_pos.height - new_height) / 2;
@@ -3477,9 +3911,36 @@ void litehtml::html_tag::calc_document_size( litehtml::size& sz, int x /*= 0*/,
 
 		if(m_overflow == overflow_visible)
 		{
-			for(auto& el : m_children)
+			// the children before the one a partial layout goes on from stay where
+			// they are, their size is added up once
+			size_t keep = (m_layout_stopped && m_resume_child > 0) ? m_resume_child : 0;
+			if(keep < m_children_size_count || !m_children_size_count)
+			{
+				m_children_size.width	= 0;
+				m_children_size.height	= 0;
+				m_children_size_count	= 0;
+			}
+			for(size_t i = 0; i < m_children.size(); i++)
+			{
+				auto& el = m_children[i];
+				// positioned elements move with the size of their containing block
+				bool moves = el->get_element_position() == element_position_absolute || el->get_element_position() == element_position_fixed;
+				if(i < keep && !moves)
+				{
+					if(i >= m_children_size_count)
+					{
+						el->calc_document_size(m_children_size);
+					}
+				} else
+				{
+					el->calc_document_size(sz, x + m_pos.x, y + m_pos.y);
+				}
+			}
+			m_children_size_count = keep;
+			if(keep)
 			{
-				el->calc_document_size(sz, x + m_pos.x, y + m_pos.y);
+				sz.width	= std::max(sz.width,	x + m_pos.x + m_children_size.width);
+				sz.height	= std::max(sz.height,	y + m_pos.y + m_children_size.height);
 			}
 		}
 
@@ -3618,11 +4079,7 @@ void litehtml::html_tag::update_floats(int dy, const element::ptr &parent)
 				fb->pos.y	+= dy;
 			}
 		}
-		if(reset_cache)
-		{
-			m_cahe_line_left.invalidate();
-		}
-		reset_cache = false;
+
 		for(floated_box::vector::reverse_iterator fb = m_floats_right.rbegin(); fb != m_floats_right.rend(); fb++)
 		{
 			if(fb->el->is_ancestor(parent))
@@ -3633,7 +4090,7 @@ void litehtml::html_tag::update_floats(int dy, const element::ptr &parent)
 		}
 		if(reset_cache)
 		{
-			m_cahe_line_right.invalidate();
+			m_float_bands.invalidate();
 		}
 	} else
 	{
@@ -4057,11 +4514,18 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 		}
 	}
 
-	m_floats_left.clear();
-	m_floats_right.clear();
-	m_boxes.clear();
-	m_cahe_line_left.invalidate();
-	m_cahe_line_right.invalidate();
+	bool resume = m_layout_resumed;
+	m_layout_resumed = false;
+	if (!resume)
+	{
+		m_floats_left.clear();
+		m_floats_right.clear();
+		m_boxes.clear();
+		m_line_items.clear();
+		m_boxes_arena.rewind();
+		m_float_bands.clear();
+	}
+	m_vertical_align_shift = 0;
 
 	element_position el_position;
 
@@ -4085,8 +4549,24 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 
 	bool was_space = false;
 
-	for (auto el : m_children)
+	// render_partial() stops the normal flow between the children of its blocks
+	document::ptr doc = get_document();
+	bool can_stop = doc->is_layout_limited() && !second_pass && is_in_main_flow();
+	int content_top = can_stop ? get_placement().y : 0;
+
+	size_t first_child = 0;
+	if (resume)
+	{
+		first_child = m_resume_child;
+		ret_width = std::max(ret_width, m_resume_ret_width);
+	}
+	m_resume_child = -1;
+
+	for (size_t i = first_child; i < m_children.size(); i++)
 	{
+		auto el = m_children[i];
+		el->set_layout_pending(false);
+
 		// we don't need process absolute and fixed positioned element on the second pass
 		if (second_pass)
 		{
@@ -4115,12 +4595,20 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 			}
 		}
 
-		// place element into rendering flow
-		int rw = place_element(el, max_width);
+		// place element into rendering flow; the element the layout stopped after
+		// goes on in its block box, placed there without floats around
+		int rw = (resume && i == first_child) ? el->render(0, m_boxes.back()->top(), max_width) : place_element(el, max_width);
 		if (rw > ret_width)
 		{
 			ret_width = rw;
 		}
+
+		// a partial layout stops after blocks only
+		if (can_stop && !m_boxes.empty() && m_boxes.back()->get_type() == box_block && doc->should_stop_layout(content_top + m_boxes.back()->bottom()))
+		{
+			stop_layout(i + 1, ret_width);
+			break;
+		}
 	}
 
 	finish_last_box(true);
@@ -4186,7 +4674,7 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 		{
 			if (el_parent->get_predefined_height(block_height))
 			{
-				min_height = m_css_min_height.calc_percent(block_height);
+				min_height = get_document()->cvt_units(m_css_min_height, m_font_size, block_height);
 			}
 		}
 	}
@@ -4224,7 +4712,7 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 		m_pos.height = min_height;
 	}
 
-	int min_width = m_css_min_width.calc_percent(parent_width);
+	int min_width = get_document()->cvt_units(m_css_min_width, m_font_size, parent_width);
 
 	if (min_width != 0 && m_box_sizing == box_sizing_border_box)
 	{
@@ -4331,45 +4819,53 @@ int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pa
 	// cell width.
 	// 
 	// Also, calculate the "maximum" cell width of each cell: formatting the content without breaking lines other than where explicit line breaks occur.
+	//
+	// Every cell is a formatting context of its own, so the cells are laid out on the layout threads of the document.
 
-	if (m_grid->cols_count() == 1 && !block_width.is_default())
+	m_grid->convert_calc_widths((block_width.is_default() ? max_width : (int) block_width) - table_width_spacing);
+
+	std::vector<std::pair<int, table_cell*>> cells;		// column and cell
+	for (int row = 0; row < m_grid->rows_count(); row++)
 	{
-		for (int row = 0; row < m_grid->rows_count(); row++)
+		for (int col = 0; col < m_grid->cols_count(); col++)
 		{
-			table_cell* cell = m_grid->cell(0, row);
+			table_cell* cell = m_grid->cell(col, row);
 			if (cell && cell->el)
 			{
-				cell->min_width = cell->max_width = cell->el->render(0, 0, max_width - table_width_spacing);
-				cell->el->m_pos.width = cell->min_width - cell->el->content_margins_left() - cell->el->content_margins_right();
+				cells.push_back(std::make_pair(col, cell));
 			}
 		}
 	}
+	task_pool* pool = get_document()->layout_pool();
+
+	if (m_grid->cols_count() == 1 && !block_width.is_default())
+	{
+		run_layout_tasks(pool, (int) cells.size(), [&](int i)
+			{
+				table_cell* cell = cells[i].second;
+				cell->min_width = cell->max_width = cell->el->render(0, 0, max_width - table_width_spacing);
+				cell->el->m_pos.width = cell->min_width - cell->el->content_margins_left() - cell->el->content_margins_right();
+			});
+	}
 	else
 	{
-		for (int row = 0; row < m_grid->rows_count(); row++)
-		{
-			for (int col = 0; col < m_grid->cols_count(); col++)
+		run_layout_tasks(pool, (int) cells.size(), [&](int i)
 			{
-				table_cell* cell = m_grid->cell(col, row);
-				if (cell && cell->el)
+				int col = cells[i].first;
+				table_cell* cell = cells[i].second;
+				if (!m_grid->column(col).css_width.is_predefined() && m_grid->column(col).css_width.units() != css_units_percentage)
 				{
-					if (!m_grid->column(col).css_width.is_predefined() && m_grid->column(col).css_width.units() != css_units_percentage)
-					{
-						int css_w = m_grid->column(col).css_width.calc_percent(block_width);
-						int el_w = cell->el->render(0, 0, css_w);
-						cell->min_width = cell->max_width = std::max(css_w, el_w);
-						cell->el->m_pos.width = cell->min_width - cell->el->content_margins_left() - cell->el->content_margins_right();
-					}
-					else
-					{
-						// calculate minimum content width
-						cell->min_width = cell->el->render(0, 0, 1);
-						// calculate maximum content width
-						cell->max_width = cell->el->render(0, 0, max_width - table_width_spacing);
-					}
+					int css_w = get_document()->cvt_units(m_grid->column(col).css_width, m_font_size, block_width);
+					int el_w = cell->el->render(0, 0, css_w);
+					cell->min_width = cell->max_width = std::max(css_w, el_w);
+					cell->el->m_pos.width = cell->min_width - cell->el->content_margins_left() - cell->el->content_margins_right();
 				}
-			}
-		}
+				else
+				{
+					// calculate minimum and maximum content width
+					cell->el->get_intrinsic_widths(max_width - table_width_spacing, cell->min_width, cell->max_width);
+				}
+			});
 	}
 
 	// For each column, determine a maximum and minimum column width from the cells that span only that column. 
@@ -4449,6 +4945,28 @@ int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pa
 	bool row_span_found = false;
 
 	// render cells with computed width
+	run_layout_tasks(pool, (int) cells.size(), [&](int i)
+		{
+			int col = cells[i].first;
+			table_cell* cell = cells[i].second;
+			int span_col = col + cell->colspan - 1;
+			if (span_col >= m_grid->cols_count())
+			{
+				span_col = m_grid->cols_count() - 1;
+			}
+			int cell_width = m_grid->column(span_col).right - m_grid->column(col).left;
+
+			if (cell->el->m_pos.width != cell_width - cell->el->content_margins_left() - cell->el->content_margins_right())
+			{
+				cell->el->render(m_grid->column(col).left, 0, cell_width);
+				cell->el->m_pos.width = cell_width - cell->el->content_margins_left() - cell->el->content_margins_right();
+			}
+			else
+			{
+				cell->el->m_pos.x = m_grid->column(col).left + cell->el->content_margins_left();
+			}
+		});
+
 	for (int row = 0; row < m_grid->rows_count(); row++)
 	{
 		m_grid->row(row).height = 0;
@@ -4457,23 +4975,6 @@ int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pa
 			table_cell* cell = m_grid->cell(col, row);
 			if (cell->el)
 			{
-				int span_col = col + cell->colspan - 1;
-				if (span_col >= m_grid->cols_count())
-				{
-					span_col = m_grid->cols_count() - 1;
-				}
-				int cell_width = m_grid->column(span_col).right - m_grid->column(col).left;
-
-				if (cell->el->m_pos.width != cell_width - cell->el->content_margins_left() - cell->el->content_margins_right())
-				{
-					cell->el->render(m_grid->column(col).left, 0, cell_width);
-					cell->el->m_pos.width = cell_width - cell->el->content_margins_left() - cell->el->content_margins_right();
-				}
-				else
-				{
-					cell->el->m_pos.x = m_grid->column(col).left + cell->el->content_margins_left();
-				}
-
 				if (cell->rowspan <= 1)
 				{
 					m_grid->row(row).height = std::max(m_grid->row(row).height, cell->el->height());
@@ -4558,7 +5059,7 @@ int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pa
 			int parent_height = 0;
 			if (el_parent->get_predefined_height(parent_height))
 			{
-				min_height = m_css_min_height.calc_percent(parent_height);
+				min_height = get_document()->cvt_units(m_css_min_height, m_font_size, parent_height);
 			}
 		}
 	}
@@ -4635,7 +5136,7 @@ void litehtml::html_tag::draw_children_box(uint_ptr hdc, int x, int y, const pos
 		border_box += m_padding;
 		border_box += m_borders;
 
-		border_radiuses bdr_radius = m_css_borders.radius.calc_percents(border_box.width, border_box.height);
+		border_radiuses bdr_radius = m_css_borders.radius.calc_percents(*get_document(), m_font_size, border_box.width, border_box.height);
 
 		bdr_radius -= m_borders;
 		bdr_radius -= m_padding;
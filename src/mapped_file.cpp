@@ -0,0 +1,134 @@
+#include "html.h"
+#include "mapped_file.h"
+
+#if defined( WIN32 ) || defined( _WIN32 ) || defined( WINCE )
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+litehtml::mapped_file::mapped_file()
+{
+	m_data		= 0;
+	m_size		= 0;
+	m_file		= 0;
+	m_mapping	= 0;
+}
+
+litehtml::mapped_file::~mapped_file()
+{
+	close();
+}
+
+#if defined( WIN32 ) || defined( _WIN32 ) || defined( WINCE )
+
+bool litehtml::mapped_file::open(const char* path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || (ULONGLONG) size.QuadPart > (ULONGLONG) SIZE_MAX)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	m_file = file;
+	m_size = (size_t) size.QuadPart;
+	if (!m_size)
+	{
+		// empty files can't be mapped
+		m_data = "";
+		return true;
+	}
+
+	m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping)
+	{
+		m_data = (const char*) MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void litehtml::mapped_file::close()
+{
+	if (m_data && m_size)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle((HANDLE) m_mapping);
+	}
+	if (m_file)
+	{
+		CloseHandle((HANDLE) m_file);
+	}
+	m_data		= 0;
+	m_size		= 0;
+	m_file		= 0;
+	m_mapping	= 0;
+}
+
+#else
+
+bool litehtml::mapped_file::open(const char* path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		::close(fd);
+		return false;
+	}
+	m_size = (size_t) st.st_size;
+	if (!m_size)
+	{
+		// empty files can't be mapped
+		::close(fd);
+		m_data = "";
+		return true;
+	}
+
+	void* data = mmap(0, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		m_size = 0;
+		return false;
+	}
+	madvise(data, m_size, MADV_SEQUENTIAL);
+	m_data = (const char*) data;
+	return true;
+}
+
+void litehtml::mapped_file::close()
+{
+	if (m_data && m_size)
+	{
+		munmap((void*) m_data, m_size);
+	}
+	m_data		= 0;
+	m_size		= 0;
+}
+
+#endif
@@ -122,6 +122,14 @@ bool litehtml::media_query::check( const media_features& features ) const
 	return res;
 }
 
+void litehtml::media_query::add_breakpoints(media_breakpoints& breakpoints) const
+{
+	for(const auto& expr : m_expressions)
+	{
+		breakpoints.add(expr);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 litehtml::media_query_list::ptr litehtml::media_query_list::create_from_string(const tstring& str, const std::shared_ptr<document>& doc)
@@ -167,6 +175,14 @@ bool litehtml::media_query_list::apply_media_features( const media_features& fea
 	return ret;
 }
 
+void litehtml::media_query_list::add_breakpoints(media_breakpoints& breakpoints) const
+{
+	for(const auto& query : m_queries)
+	{
+		query->add_breakpoints(breakpoints);
+	}
+}
+
 bool litehtml::media_query_expression::check( const media_features& features ) const
 {
 	switch(feature)
@@ -430,3 +446,115 @@ bool litehtml::media_query_expression::check( const media_features& features ) c
 
 	return false;
 }
+
+//////////////////////////////////////////////////////////////////////////
+
+void litehtml::media_breakpoints::add(const media_query_expression& expr)
+{
+	switch(expr.feature)
+	{
+	case media_feature_width:
+	case media_feature_min_width:
+	case media_feature_max_width:
+		add_threshold(dimension_width, expr.check_as_bool ? 0 : expr.val);
+		break;
+	case media_feature_height:
+	case media_feature_min_height:
+	case media_feature_max_height:
+		add_threshold(dimension_height, expr.check_as_bool ? 0 : expr.val);
+		break;
+	case media_feature_device_width:
+	case media_feature_min_device_width:
+	case media_feature_max_device_width:
+		add_threshold(dimension_device_width, expr.check_as_bool ? 0 : expr.val);
+		break;
+	case media_feature_device_height:
+	case media_feature_min_device_height:
+	case media_feature_max_device_height:
+		add_threshold(dimension_device_height, expr.check_as_bool ? 0 : expr.val);
+		break;
+	case media_feature_aspect_ratio:
+	case media_feature_min_aspect_ratio:
+	case media_feature_max_aspect_ratio:
+		if(expr.val2)
+		{
+			add_threshold(dimension_aspect_ratio, round_d( (double) expr.val / (double) expr.val2 * 100 ));
+		}
+		break;
+	case media_feature_device_aspect_ratio:
+	case media_feature_min_device_aspect_ratio:
+	case media_feature_max_device_aspect_ratio:
+		if(expr.val2)
+		{
+			add_threshold(dimension_device_aspect_ratio, round_d( (double) expr.val / (double) expr.val2 * 100 ));
+		}
+		break;
+	case media_feature_color:
+	case media_feature_min_color:
+	case media_feature_max_color:
+		add_threshold(dimension_color, expr.check_as_bool ? 0 : expr.val);
+		break;
+	case media_feature_color_index:
+	case media_feature_min_color_index:
+	case media_feature_max_color_index:
+		add_threshold(dimension_color_index, expr.check_as_bool ? 0 : expr.val);
+		break;
+	case media_feature_monochrome:
+	case media_feature_min_monochrome:
+	case media_feature_max_monochrome:
+		add_threshold(dimension_monochrome, expr.check_as_bool ? 0 : expr.val);
+		break;
+	case media_feature_resolution:
+	case media_feature_min_resolution:
+	case media_feature_max_resolution:
+		add_threshold(dimension_resolution, expr.val);
+		break;
+	default:
+		// orientation is always a part of the signature
+		break;
+	}
+}
+
+void litehtml::media_breakpoints::add_threshold(dimension dim, int val)
+{
+	int_vector& thresholds = m_thresholds[dim];
+	int_vector::iterator iter = std::lower_bound(thresholds.begin(), thresholds.end(), val);
+	if(iter == thresholds.end() || *iter != val)
+	{
+		thresholds.insert(iter, val);
+	}
+}
+
+void litehtml::media_breakpoints::get_signature(const media_features& features, int_vector& signature) const
+{
+	int values[dimensions_count];
+	values[dimension_width]			= features.width;
+	values[dimension_height]		= features.height;
+	values[dimension_device_width]	= features.device_width;
+	values[dimension_device_height]	= features.device_height;
+	values[dimension_aspect_ratio]	= features.height ? round_d( (double) features.width / (double) features.height * 100.0 ) : 0;
+	values[dimension_device_aspect_ratio] = features.device_height ? round_d( (double) features.device_width / (double) features.device_height * 100.0 ) : 0;
+	values[dimension_color]			= features.color;
+	values[dimension_color_index]	= features.color_index;
+	values[dimension_monochrome]	= features.monochrome;
+	values[dimension_resolution]	= features.resolution;
+
+	signature.clear();
+	signature.push_back((int) features.type);
+	signature.push_back(features.height >= features.width ? 1 : 0);
+	// aspect ratios never match for zero height
+	signature.push_back(features.height ? 1 : 0);
+	signature.push_back(features.device_height ? 1 : 0);
+	for(int dim = 0; dim < dimensions_count; dim++)
+	{
+		// index of the range between thresholds, odd if the value equals to the threshold
+		const int_vector& thresholds = m_thresholds[dim];
+		int_vector::const_iterator iter = std::lower_bound(thresholds.begin(), thresholds.end(), values[dim]);
+		int range = (int) (iter - thresholds.begin()) * 2;
+		if(iter != thresholds.end() && *iter == values[dim])
+		{
+			range++;
+		}
+		signature.push_back(range);
+	}
+}
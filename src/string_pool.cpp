@@ -0,0 +1,43 @@
+#include "html.h"
+#include "string_pool.h"
+#include <mutex>
+#include <unordered_set>
+
+namespace
+{
+	struct string_pool
+	{
+		// the set never erases, so pointers into its strings stay valid
+		std::unordered_set<litehtml::tstring>	strings;
+		std::mutex								mutex;
+	};
+
+	// created on first use, so stylesheets can be parsed during static initialization
+	string_pool& get_pool()
+	{
+		static string_pool pool;
+		return pool;
+	}
+}
+
+const litehtml::tchar_t* litehtml::intern_string(const tchar_t* str)
+{
+	string_pool& pool = get_pool();
+	tstring key(str);
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	auto iter = pool.strings.find(key);
+	if(iter == pool.strings.end())
+	{
+		iter = pool.strings.insert(std::move(key)).first;
+	}
+	return iter->c_str();
+}
+
+const litehtml::tchar_t* litehtml::find_interned_string(const tchar_t* str)
+{
+	string_pool& pool = get_pool();
+	tstring key(str);
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	auto iter = pool.strings.find(key);
+	return iter == pool.strings.end() ? 0 : iter->c_str();
+}
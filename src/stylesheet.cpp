@@ -8,14 +8,7 @@ void litehtml::css::parse_stylesheet(const tchar_t* str, const tchar_t* baseurl,
 {
 	tstring text = str;
 
-	// remove comments
-	tstring::size_type c_start = text.find(_t("/*"));
-	while(c_start != tstring::npos)
-	{
-		tstring::size_type c_end = text.find(_t("*/"), c_start + 2);
-		text.erase(c_start, c_end - c_start + 2);
-		c_start = text.find(_t("/*"));
-	}
+	remove_comments(text);
 
 	tstring::size_type pos = text.find_first_not_of(_t(" \n\r\t"));
 	while(pos != tstring::npos)
@@ -99,6 +92,39 @@ void litehtml::css::parse_css_url( const tstring& str, tstring& url )
 	}
 }
 
+void litehtml::css::collect_imports(const tchar_t* str, string_vector& urls)
+{
+	tstring text = str;
+
+	remove_comments(text);
+
+	// @import rules are only allowed at the top of the stylesheet,
+	// optionally preceded by @charset
+	tstring::size_type pos = text.find_first_not_of(_t(" \n\r\t"));
+	while(pos != tstring::npos && text[pos] == _t('@'))
+	{
+		tstring::size_type end = text.find(_t(';'), pos);
+		tstring rule = text.substr(pos, end == tstring::npos ? tstring::npos : end - pos + 1);
+		if(rule.substr(0, 7) == _t("@import"))
+		{
+			tstring url;
+			tstring media_str;
+			if(parse_import(rule, url, media_str))
+			{
+				urls.push_back(url);
+			}
+		} else if(rule.substr(0, 8) != _t("@charset"))
+		{
+			break;
+		}
+		if(end == tstring::npos)
+		{
+			break;
+		}
+		pos = text.find_first_not_of(_t(" \n\r\t"), end + 1);
+	}
+}
+
 bool litehtml::css::parse_selectors( const tstring& txt, const litehtml::style::ptr& styles, const media_query_list::ptr& media )
 {
 	tstring selector = txt;
@@ -134,64 +160,60 @@ void litehtml::css::sort_selectors()
 	);
 }
 
-void litehtml::css::parse_atrule(const tstring& text, const tchar_t* baseurl, const std::shared_ptr<document>& doc, const media_query_list::ptr& media)
+void litehtml::css::merge(const css& stylesheet)
 {
-	if(text.substr(0, 7) == _t("@import"))
+	// the selectors are already sorted, so only the new ones are sorted and merged in
+	size_t count = m_selectors.size();
+	for(const auto& sel : stylesheet.m_selectors)
+	{
+		add_selector(sel);
+	}
+	auto less = [](const css_selector::ptr& v1, const css_selector::ptr& v2)
 	{
-		int sPos = 7;
-		tstring iStr;
-		iStr = text.substr(sPos);
-		if(iStr[iStr.length() - 1] == _t(';'))
+		return (*v1) < (*v2);
+	};
+	std::sort(m_selectors.begin() + count, m_selectors.end(), less);
+	std::inplace_merge(m_selectors.begin(), m_selectors.begin() + count, m_selectors.end(), less);
+}
+
+bool litehtml::css::contains(const css_selector::ptr& selector) const
+{
+	css_selector::vector::const_iterator iter = std::lower_bound(m_selectors.begin(), m_selectors.end(), selector,
+		[](const css_selector::ptr& v1, const css_selector::ptr& v2)
 		{
-			iStr.erase(iStr.length() - 1);
+			return (*v1) < (*v2);
 		}
-		trim(iStr);
-		string_vector tokens;
-		split_string(iStr, tokens, _t(" "), _t(""), _t("(\""));
-		if(!tokens.empty())
+	);
+	return iter != m_selectors.end() && *iter == selector;
+}
+
+void litehtml::css::parse_atrule(const tstring& text, const tchar_t* baseurl, const std::shared_ptr<document>& doc, const media_query_list::ptr& media)
+{
+	if(text.substr(0, 7) == _t("@import"))
+	{
+		tstring url;
+		tstring media_str;
+		if(parse_import(text, url, media_str) && doc && doc->container())
 		{
-			tstring url;
-			parse_css_url(tokens.front(), url);
-			if(url.empty())
+			tstring css_text;
+			tstring css_baseurl;
+			if(baseurl)
 			{
-				url = tokens.front();
+				css_baseurl = baseurl;
 			}
-			tokens.erase(tokens.begin());
-			if(doc)
+			doc->import_css(css_text, url, css_baseurl);
+			if(!css_text.empty())
 			{
-				document_container* doc_cont = doc->container();
-				if(doc_cont)
+				media_query_list::ptr new_media = media;
+				if(!media_str.empty())
 				{
-					tstring css_text;
-					tstring css_baseurl;
-					if(baseurl)
-					{
-						css_baseurl = baseurl;
-					}
-					doc_cont->import_css(css_text, url, css_baseurl);
-					if(!css_text.empty())
+					new_media = media_query_list::create_from_string(media_str, doc);
+					if(!new_media)
 					{
-						media_query_list::ptr new_media = media;
-						if(!tokens.empty())
-						{
-							tstring media_str;
-							for(string_vector::iterator iter = tokens.begin(); iter != tokens.end(); iter++)
-							{
-								if(iter != tokens.begin())
-								{
-									media_str += _t(" ");
-								}
-								media_str += (*iter);
-							}
-							new_media = media_query_list::create_from_string(media_str, doc);
-							if(!new_media)
-							{
-								new_media = media;
-							}
-						}
-						parse_stylesheet(css_text.c_str(), css_baseurl.c_str(), doc, new_media);
+						new_media = media;
 					}
 				}
+				parse_stylesheet(css_text.c_str(), css_baseurl.c_str(), doc, new_media);
 			}
 		}
 	} else if(text.substr(0, 6) == _t("@media"))
@@ -217,3 +239,51 @@ void litehtml::css::parse_atrule(const tstring& text, const tchar_t* baseurl, co
 		}
 	}
 }
+
+bool litehtml::css::parse_import(const tstring& text, tstring& url, tstring& media_str)
+{
+	tstring iStr = text.substr(7);
+	if(!iStr.empty() && iStr[iStr.length() - 1] == _t(';'))
+	{
+		iStr.erase(iStr.length() - 1);
+	}
+	trim(iStr);
+	string_vector tokens;
+	split_string(iStr, tokens, _t(" "), _t(""), _t("(\""));
+	if(tokens.empty())
+	{
+		return false;
+	}
+	parse_css_url(tokens.front(), url);
+	if(url.empty())
+	{
+		url = tokens.front();
+		// @import "file.css";
+		if(url.length() >= 2 && (url[0] == _t('"') || url[0] == _t('\'')) && url[url.length() - 1] == url[0])
+		{
+			url = url.substr(1, url.length() - 2);
+		}
+	}
+	tokens.erase(tokens.begin());
+	media_str.clear();
+	for(string_vector::iterator iter = tokens.begin(); iter != tokens.end(); iter++)
+	{
+		if(iter != tokens.begin())
+		{
+			media_str += _t(" ");
+		}
+		media_str += (*iter);
+	}
+	return true;
+}
+
+void litehtml::css::remove_comments(tstring& text)
+{
+	tstring::size_type c_start = text.find(_t("/*"));
+	while(c_start != tstring::npos)
+	{
+		tstring::size_type c_end = text.find(_t("*/"), c_start + 2);
+		text.erase(c_start, c_end - c_start + 2);
+		c_start = text.find(_t("/*"));
+	}
+}
@@ -1,6 +1,7 @@
 #include "html.h"
 #include "table.h"
 #include "html_tag.h"
+#include "document.h"
 
 void litehtml::table_grid::add_cell(element::ptr& el)
 {
@@ -127,6 +128,10 @@ void litehtml::table_grid::finish()
 
 	for(int col = 0; col < m_cols_count; col++)
 	{
+		if(m_columns[col].css_width.calc_terms())
+		{
+			m_columns[col].css_calc_width = m_columns[col].css_width;
+		}
 		for(int row = 0; row < m_rows_count; row++)
 		{
 			if(cell(col, row)->el)
@@ -137,6 +142,29 @@ void litehtml::table_grid::finish()
 	}
 }
 
+// calc() widths may depend on the font size of the cells and on the viewport, so they
+// are converted into pixels for every layout
+void litehtml::table_grid::convert_calc_widths(int block_width)
+{
+	for(int col = 0; col < m_cols_count; col++)
+	{
+		table_column& column = m_columns[col];
+		if(!column.css_calc_width.calc_terms())
+		{
+			continue;
+		}
+		for(int row = 0; row < m_rows_count; row++)
+		{
+			element::ptr el = cell(col, row)->el;
+			if(el)
+			{
+				column.css_width.set_value((float) el->get_document()->cvt_units(column.css_calc_width, el->get_font_size(), block_width), css_units_px);
+				break;
+			}
+		}
+	}
+}
+
 litehtml::table_cell* litehtml::table_grid::cell( int t_col, int t_row )
 {
 	if(t_col >= 0 && t_col < m_cols_count && t_row >= 0 && t_row < m_rows_count)
@@ -452,6 +480,16 @@ void litehtml::table_grid::calc_vertical_positions( margins& table_borders, bord
 	}
 }
 
+// the css height of the row in pixels, calc() terms included
+static int row_css_height(litehtml::table_row& row, int block_height)
+{
+	if(row.el_row)
+	{
+		return row.el_row->get_document()->cvt_units(row.css_height, row.el_row->get_font_size(), block_height);
+	}
+	return row.css_height.calc_percent(block_height);
+}
+
 void litehtml::table_grid::calc_rows_height(int blockHeight, int borderSpacingY)
 {
 	int min_table_height = 0;
@@ -463,9 +501,10 @@ void litehtml::table_grid::calc_rows_height(int blockHeight, int borderSpacingY)
 		{
 			if (row.css_height.units() != css_units_percentage)
 			{
-				if (row.height < (int)row.css_height.val())
+				int css_height = row_css_height(row, 0);
+				if (row.height < css_height)
 				{
-					row.height = (int)row.css_height.val();
+					row.height = css_height;
 				}
 			}
 		}
@@ -483,7 +522,7 @@ void litehtml::table_grid::calc_rows_height(int blockHeight, int borderSpacingY)
 		{
 			if (!row.css_height.is_predefined() && row.css_height.units() == css_units_percentage)
 			{
-				row.height = row.css_height.calc_percent(blockHeight);
+				row.height = row_css_height(row, blockHeight);
 				if (row.height < row.min_height)
 				{
 					row.height = row.min_height;
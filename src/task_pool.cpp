@@ -0,0 +1,106 @@
+#include "html.h"
+#include "task_pool.h"
+
+litehtml::task_pool::task_pool(int threads)
+{
+	m_stop = false;
+	for(int i = 0; i < threads; i++)
+	{
+		m_threads.push_back(std::thread(&task_pool::thread_proc, this));
+	}
+}
+
+litehtml::task_pool::~task_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for(auto& th : m_threads)
+	{
+		th.join();
+	}
+}
+
+void litehtml::task_pool::run(int count, const std::function<void(int)>& fn)
+{
+	if(count <= 1 || m_threads.empty())
+	{
+		for(int i = 0; i < count; i++)
+		{
+			fn(i);
+		}
+		return;
+	}
+
+	loop lp;
+	lp.fn		= &fn;
+	lp.count	= count;
+	lp.next		= 0;
+	lp.done		= 0;
+	lp.workers	= 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_loops.push_back(&lp);
+	}
+	m_wake.notify_all();
+
+	work(lp);
+
+	// the other threads may still run the last iterations
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_loops.remove(&lp);
+	m_finished.wait(lock, [&lp]() { return lp.done == lp.count && !lp.workers; });
+}
+
+void litehtml::task_pool::thread_proc()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(true)
+	{
+		loop* lp = 0;
+		for(auto it = m_loops.begin(); it != m_loops.end(); )
+		{
+			if((*it)->next >= (*it)->count)
+			{
+				it = m_loops.erase(it);
+			} else
+			{
+				lp = *it;
+				break;
+			}
+		}
+		if(lp)
+		{
+			// run() waits for the thread to leave the loop before it returns
+			lp->workers++;
+			lock.unlock();
+			work(*lp);
+			lock.lock();
+			if(!--lp->workers)
+			{
+				m_finished.notify_all();
+			}
+		} else if(m_stop)
+		{
+			break;
+		} else
+		{
+			m_wake.wait(lock);
+		}
+	}
+}
+
+void litehtml::task_pool::work(loop& lp)
+{
+	for(int i = lp.next++; i < lp.count; i = lp.next++)
+	{
+		(*lp.fn)(i);
+		if(++lp.done == lp.count)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finished.notify_all();
+		}
+	}
+}
@@ -1,16 +1,75 @@
 #include "html.h"
 #include "utf8_strings.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LITEHTML_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Copies the ASCII bytes at the start of [str, end) to out, widening them to
+	// wchar_t, and returns the number of bytes copied. Stops at the first byte
+	// that starts a multi-byte sequence.
+	size_t widen_ascii(const litehtml::byte* str, const litehtml::byte* end, wchar_t* out)
+	{
+		const litehtml::byte* p = str;
+#ifdef LITEHTML_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		while (end - p >= 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*) p);
+			if (_mm_movemask_epi8(v))
+			{
+				break;
+			}
+			__m128i lo = _mm_unpacklo_epi8(v, zero);
+			__m128i hi = _mm_unpackhi_epi8(v, zero);
+			if (sizeof(wchar_t) == 2)
+			{
+				_mm_storeu_si128((__m128i*) out, lo);
+				_mm_storeu_si128((__m128i*) (out + 8), hi);
+			} else
+			{
+				_mm_storeu_si128((__m128i*) out, _mm_unpacklo_epi16(lo, zero));
+				_mm_storeu_si128((__m128i*) (out + 4), _mm_unpackhi_epi16(lo, zero));
+				_mm_storeu_si128((__m128i*) (out + 8), _mm_unpacklo_epi16(hi, zero));
+				_mm_storeu_si128((__m128i*) (out + 12), _mm_unpackhi_epi16(hi, zero));
+			}
+			p	+= 16;
+			out	+= 16;
+		}
+#endif
+		while (p < end && *p < 0x80)
+		{
+			*out++ = *p++;
+		}
+		return p - str;
+	}
+}
 
 litehtml::utf8_to_wchar::utf8_to_wchar(const char* val)
 {
 	m_utf8 = (const byte*) val;
-	while (true)
+	const byte* end = m_utf8 + strlen(val);
+
+	// every character takes at least one byte
+	m_str.resize(end - m_utf8);
+	wchar_t* out = &m_str[0];
+	while (m_utf8 < end)
 	{
+		size_t ascii = widen_ascii(m_utf8, end, out);
+		m_utf8	+= ascii;
+		out		+= ascii;
+		if (m_utf8 >= end)
+		{
+			break;
+		}
 		ucode_t wch = get_char();
 		if (!wch) break;
-		m_str += wch;
+		*out++ = (wchar_t) wch;
 	}
+	m_str.resize(out - m_str.c_str());
 }
 
 litehtml::ucode_t litehtml::utf8_to_wchar::get_char()
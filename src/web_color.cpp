@@ -154,72 +154,152 @@ litehtml::def_color litehtml::g_def_colors[] =
 };
 
 
-litehtml::web_color litehtml::web_color::from_string(const tchar_t* str, litehtml::document_container* callback)
+#include "web_color_hash.inc"
+
+namespace
 {
-	if(!str || !str[0])
+	// case insensitive FNV-1a, must match tool/web_color_hash.py
+	unsigned int color_name_hash(const litehtml::tchar_t* name, unsigned int seed)
 	{
-		return web_color(0, 0, 0);
+		unsigned int hash = 2166136261u ^ seed;
+		for(; *name; name++)
+		{
+			unsigned int c = (unsigned int) *name;
+			if(c >= 'A' && c <= 'Z')
+			{
+				c += 'a' - 'A';
+			}
+			hash = (hash ^ c) * 16777619u;
+		}
+		return hash;
 	}
-	if(str[0] == _t('#'))
+
+	int hex_digit(litehtml::tchar_t c)
+	{
+		if(c >= _t('0') && c <= _t('9'))	return c - _t('0');
+		if(c >= _t('a') && c <= _t('f'))	return c - _t('a') + 10;
+		if(c >= _t('A') && c <= _t('F'))	return c - _t('A') + 10;
+		return -1;
+	}
+
+	// two hex digits parsed the same way as t_strtol does: stops at the first invalid digit
+	litehtml::byte hex_byte(litehtml::tchar_t hi, litehtml::tchar_t lo)
 	{
-		tstring red		= _t("");
-		tstring green		= _t("");
-		tstring blue		= _t("");
-		if(t_strlen(str + 1) == 3)
+		int h = hex_digit(hi);
+		if(h < 0)
 		{
-			red		+= str[1];
-			red		+= str[1];
-			green	+= str[2];
-			green	+= str[2];
-			blue	+= str[3];
-			blue	+= str[3];
-		} else if(t_strlen(str + 1) == 6)
+			return 0;
+		}
+		int l = hex_digit(lo);
+		if(l < 0)
 		{
-			red		+= str[1];
-			red		+= str[2];
-			green	+= str[3];
-			green	+= str[4];
-			blue	+= str[5];
-			blue	+= str[6];
+			return (litehtml::byte) h;
 		}
-		tchar_t* sss = 0;
-		web_color clr;
-		clr.red		= (byte) t_strtol(red.c_str(),	&sss, 16);
-		clr.green	= (byte) t_strtol(green.c_str(),	&sss, 16);
-		clr.blue	= (byte) t_strtol(blue.c_str(),	&sss, 16);
-		return clr;
-	} else if(!t_strncmp(str, _t("rgb"), 3))
+		return (litehtml::byte) (h * 16 + l);
+	}
+
+	// "#rgb" or "#rrggbb", other lengths give black
+	litehtml::web_color parse_hex_color(const litehtml::tchar_t* str)
+	{
+		size_t len = t_strlen(str + 1);
+		if(len == 3)
+		{
+			return litehtml::web_color(hex_byte(str[1], str[1]), hex_byte(str[2], str[2]), hex_byte(str[3], str[3]));
+		} else if(len == 6)
+		{
+			return litehtml::web_color(hex_byte(str[1], str[2]), hex_byte(str[3], str[4]), hex_byte(str[5], str[6]));
+		}
+		return litehtml::web_color(0, 0, 0);
+	}
+
+	// "rgb(r, g, b)" or "rgba(r, g, b, a)", the values can be separated with commas and/or spaces
+	litehtml::web_color parse_rgb_color(const litehtml::tchar_t* str)
 	{
-		tstring s = str;
+		litehtml::web_color clr;
 
-		tstring::size_type pos = s.find_first_of(_t("("));
-		if(pos != tstring::npos)
+		const litehtml::tchar_t* pos = str;
+		while(*pos && *pos != _t('('))
 		{
-			s.erase(s.begin(), s.begin() + pos + 1);
+			pos++;
 		}
-		pos = s.find_last_of(_t(")"));
-		if(pos != tstring::npos)
+		if(*pos)
 		{
-			s.erase(s.begin() + pos, s.end());
+			pos++;
+		} else
+		{
+			pos = str;
 		}
 
-		std::vector<tstring> tokens;
-		split_string(s, tokens, _t(", \t"));
-
-		web_color clr;
+		for(int idx = 0; idx < 4; idx++)
+		{
+			while(*pos == _t(',') || *pos == _t(' ') || *pos == _t('\t'))
+			{
+				pos++;
+			}
+			if(!*pos || *pos == _t(')'))
+			{
+				break;
+			}
+			const litehtml::tchar_t* token = pos;
+			while(*pos && *pos != _t(',') && *pos != _t(' ') && *pos != _t('\t') && *pos != _t(')'))
+			{
+				pos++;
+			}
+			if(idx < 3)
+			{
+				litehtml::byte val = (litehtml::byte) t_strtol(token, nullptr, 10);
+				switch(idx)
+				{
+				case 0:	clr.red		= val;	break;
+				case 1:	clr.green	= val;	break;
+				case 2:	clr.blue	= val;	break;
+				}
+			} else
+			{
+				clr.alpha = (litehtml::byte) (t_strtod(token, nullptr) * 255.0);
+			}
+		}
+		return clr;
+	}
 
-		if(tokens.size() >= 1)	clr.red		= (byte) t_atoi(tokens[0].c_str());
-		if(tokens.size() >= 2)	clr.green	= (byte) t_atoi(tokens[1].c_str());
-		if(tokens.size() >= 3)	clr.blue	= (byte) t_atoi(tokens[2].c_str());
-		if(tokens.size() >= 4)	clr.alpha	= (byte) (t_strtod(tokens[3].c_str(), 0) * 255.0);
+	const litehtml::def_color* find_def_color(const litehtml::tchar_t* name)
+	{
+		unsigned int bucket = color_name_hash(name, 0) % WEB_COLOR_HASH_BUCKETS;
+		int idx = g_color_hash_slots[color_name_hash(name, g_color_hash_seeds[bucket]) % WEB_COLOR_HASH_SLOTS];
+		if(idx >= 0 && !t_strcasecmp(name, litehtml::g_def_colors[idx].name))
+		{
+			return &litehtml::g_def_colors[idx];
+		}
+		return nullptr;
+	}
+}
 
-		return clr;
+litehtml::web_color litehtml::web_color::from_string(const tchar_t* str, litehtml::document_container* callback)
+{
+	if(!str || !str[0])
+	{
+		return web_color(0, 0, 0);
+	}
+	if(str[0] == _t('#'))
+	{
+		return parse_hex_color(str);
+	} else if(!t_strncmp(str, _t("rgb"), 3))
+	{
+		return parse_rgb_color(str);
 	} else
 	{
-		tstring rgb = resolve_name(str, callback);
-		if(!rgb.empty())
+		const def_color* def = find_def_color(str);
+		if(def)
 		{
-			return from_string(rgb.c_str(), callback);
+			return from_string(def->rgb, callback);
+		}
+		if(callback)
+		{
+			tstring rgb = callback->resolve_color(str);
+			if(!rgb.empty())
+			{
+				return from_string(rgb.c_str(), callback);
+			}
 		}
 	}
 	return web_color(0, 0, 0);
@@ -227,19 +307,16 @@ litehtml::web_color litehtml::web_color::from_string(const tchar_t* str, litehtm
 
 litehtml::tstring litehtml::web_color::resolve_name(const tchar_t* name, litehtml::document_container* callback)
 {
-	for(int i=0; g_def_colors[i].name; i++)
+	const def_color* def = find_def_color(name);
+	if(def)
 	{
-		if(!t_strcasecmp(name, g_def_colors[i].name))
-		{
-            return std::move(litehtml::tstring(g_def_colors[i].rgb));
-		}
+		return litehtml::tstring(def->rgb);
+	}
+	if (callback)
+	{
+		return callback->resolve_color(name);
 	}
-    if (callback)
-    {
-        litehtml::tstring clr = callback->resolve_color(name);
-        return std::move(clr);
-    }
-    return std::move(litehtml::tstring());
+	return litehtml::tstring();
 }
 
 bool litehtml::web_color::is_color(const tchar_t* str)
@@ -30,6 +30,15 @@ static void CssParseUrlTest() {
   css::parse_css_url(_t("url(\"value\")"), url), assert(!t_strcmp(url.c_str(), _t("value")));
 }
 
+static void CssCollectImportsTest() {
+  string_vector urls;
+  css::collect_imports(_t("@charset \"utf-8\"; /* c */ @import url(a.css); @import \"b.css\" print; @import 'c.css'; p { color: red } @import \"d.css\";"), urls);
+  assert(urls.size() == 3);
+  assert(!t_strcmp(urls[0].c_str(), _t("a.css"))), assert(!t_strcmp(urls[1].c_str(), _t("b.css"))), assert(!t_strcmp(urls[2].c_str(), _t("c.css")));
+  urls.clear();
+  css::collect_imports(_t("p { color: red }"), urls), assert(urls.empty());
+}
+
 static void CssLengthParseTest() {
   css_length length;
   length.fromString(_t("calc(todo)")), assert(length.is_predefined() == true), assert(length.predef() == 0), assert(length.val() == 0), assert(length.units() == css_units_none);
@@ -40,6 +49,18 @@ static void CssLengthParseTest() {
   length.fromString(_t("123px"), _t("top;bottom"), -1), assert(length.is_predefined() == false), assert(length.predef() == 0), assert(length.val() == 123), assert(length.units() == css_units_px);
 }
 
+static void CssLengthCalcParseTest() {
+  css_length length;
+  length.fromString(_t("calc(100% - 20px)")), assert(length.is_predefined() == false), assert(length.units() == css_units_percentage), assert(length.val() == 100), assert(length.calc_percent(200) == 180);
+  length.fromString(_t("calc(10px * 2 + 5px)")), assert(length.is_predefined() == false), assert(length.units() == css_units_px), assert(length.val() == 25), assert(!length.calc_terms());
+  length.fromString(_t("calc((50% + 10px) / 2)")), assert(length.units() == css_units_percentage), assert(length.val() == 25), assert(length.calc_percent(100) == 30);
+  length.fromString(_t("calc(2 * calc(1em - -3px))")), assert(length.units() == css_units_px), assert(length.val() == 6), assert(length.calc_terms()->size() == 1), assert((*length.calc_terms())[0].units == css_units_em), assert((*length.calc_terms())[0].value == 2);
+  length.fromString(_t("calc(10px * 5px)"), _t("auto"), 0), assert(length.is_predefined() == true), assert(length.predef() == 0);
+  length.fromString(_t("calc(10px / 0)"), _t("auto"), 0), assert(length.is_predefined() == true);
+  length.fromString(_t("calc(10px + 1foo)"), _t("auto"), 0), assert(length.is_predefined() == true);
+  length.fromString(_t("calc(10px"), _t("auto"), 0), assert(length.is_predefined() == true);
+}
+
 static void CssElementSelectorParseTest() {
   css_element_selector selector;
   // https://www.w3schools.com/cssref/css_selectors.asp
@@ -203,7 +224,9 @@ static void StyleAddPropertyTest() {
 void cssTest() {
   CssParseTest();
   CssParseUrlTest();
+  CssCollectImportsTest();
   CssLengthParseTest();
+  CssLengthCalcParseTest();
   CssElementSelectorParseTest();
   CssSelectorParseTest();
   StyleAddTest();
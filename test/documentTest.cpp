@@ -1,6 +1,12 @@
 #include <assert.h>
 #include "litehtml.h"
+#include "litehtml/utf8_strings.h"
+#include "litehtml/arena.h"
+#include "litehtml/el_text_run.h"
+#include "litehtml/string_pool.h"
+#include "litehtml/task_pool.h"
 #include "test/container_test.h"
+#include "gumbo.h"
 using namespace litehtml;
 
 static void AddFontTest() {
@@ -48,6 +54,21 @@ static void CvtUnitsTest() {
   c.fromString(_t("10vmin")), doc->cvt_units(c, 10, 100);
   c.fromString(_t("10vmax")), doc->cvt_units(c, 10, 100);
   c.fromString(_t("10")), doc->cvt_units(c, 10, 100);
+  c.fromString(_t("calc(2em + 10px)")), assert(doc->cvt_units(c, 10, 100) == 30), assert(c.calc_terms()), assert(doc->cvt_units(c, 20, 0) == 50);
+  c.fromString(_t("calc(50% - 1em)")), assert(doc->cvt_units(c, 10, 100) == 40), assert(doc->cvt_units(c, 10, 200) == 90);
+}
+
+static void CalcLayoutTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("div { display: block } table { display: table } tr { display: table-row } td { display: table-cell }"));
+  container_test container;
+  document::ptr doc = document::createFromUTF8("<table style='width:400px'><tr style='height:calc(10px + 1em)'><td id=calc style='width:calc(50% - 2em)'></td><td></td></tr></table>"
+    "<div id=font style='font-size:calc(100% + 1em)'></div>", &container, &ctx);
+  doc->render(800);
+  element::ptr td = doc->root()->select_one(_t("#calc"));
+  assert(td->get_placement().width == 168);
+  assert(td->get_placement().height == 26);
+  assert(doc->root()->select_one(_t("#font"))->get_font_size() == 32);
 }
 
 static void MouseEventsTest() {
@@ -96,13 +117,702 @@ static void ParseTest() {
   document::createFromString(_t(""), &container, &ctx);
 }
 
+static void AsyncImportTest() {
+  context ctx;
+  container_test container;
+  container.add_css_file(_t("a.css"), _t("@import url(b.css); p { color: red }"));
+  container.add_css_file(_t("b.css"), _t("/* nested */ @import \"c.css\" screen; p { font-size: 20px }"));
+  container.add_css_file(_t("c.css"), _t("p { text-align: center }"));
+  container.add_css_file(_t("d.css"), _t("p { font-weight: bold }"));
+  const tchar_t* html = _t("<html><head><link rel=\"stylesheet\" href=\"a.css\"><style>@import url(d.css);</style></head><p>Body</p></html>");
+
+  document::ptr ready;
+  document::createFromStringAsync(html, &container, &ctx, [&ready](const document::ptr& doc) { ready = doc; });
+  assert(!ready);
+  assert(container.deliver_imports() == 2);  // a.css, d.css
+  assert(!ready);
+  assert(container.deliver_imports() == 1);  // b.css
+  assert(!ready);
+  assert(container.deliver_imports() == 1);  // c.css
+  assert(ready);
+  assert(container.deliver_imports() == 0);
+
+  document::ptr doc = document::createFromString(html, &container, &ctx);
+  element::ptr p_async = ready->root()->select_one(_t("p"));
+  element::ptr p_sync = doc->root()->select_one(_t("p"));
+  const tchar_t* props[] = { _t("color"), _t("font-size"), _t("text-align"), _t("font-weight") };
+  for (const tchar_t* prop : props) {
+    assert(p_async->get_style_property(prop, false));
+    assert(!t_strcmp(p_async->get_style_property(prop, false), p_sync->get_style_property(prop, false)));
+  }
+
+  // no stylesheets to load: on_ready is called immediately
+  ready = nullptr;
+  document::createFromStringAsync(_t("<html>Body</html>"), &container, &ctx, [&ready](const document::ptr& doc) { ready = doc; });
+  assert(ready);
+}
+
+static void AppendStylesheetTest() {
+  context ctx;
+  container_test container;
+  document::ptr doc = document::createFromString(_t("<html><style>#x { color: red } p { color: blue }</style><p id=\"x\">A</p><p>B<span>C</span></p><div>D</div></html>"), &container, &ctx);
+  assert(doc->append_stylesheet(_t("p { color: green; font-size: 20px }")));
+  elements_vector p = doc->root()->select_all(_t("p"));
+  assert(!t_strcmp(p[0]->get_style_property(_t("color"), false), _t("red")));
+  assert(!t_strcmp(p[1]->get_style_property(_t("color"), false), _t("green")));
+  assert(!t_strcmp(p[0]->get_style_property(_t("font-size"), false), _t("20px")));
+  assert(p[1]->get_font_size() == 20);
+  assert(doc->root()->select_one(_t("span"))->get_font_size() == 20);
+  assert(!doc->append_stylesheet(_t("table { color: green }")));
+  assert(!doc->append_stylesheet(_t("#x { color: black }"), nullptr, _t("print")));
+  assert(!t_strcmp(p[0]->get_style_property(_t("color"), false), _t("red")));
+  assert(doc->append_stylesheet(_t("@media print { div { color: black } } #x { color: gray }")));
+  assert(!t_strcmp(p[0]->get_style_property(_t("color"), false), _t("gray")));
+  doc->render(100);
+}
+
+static void SplitUtf8TextTest() {
+  std::vector<std::string> pieces;
+  auto split = [&pieces](const char* str) {
+    pieces.clear();
+    split_utf8_text(str, [&pieces](const char* piece, size_t length, bool is_space) {
+      pieces.push_back((is_space ? "S:" : "W:") + std::string(piece, length));
+    });
+  };
+  split("");
+  assert(pieces.empty());
+  split("one  two\tthree\n");
+  assert((pieces == std::vector<std::string>{ "W:one", "S: ", "S: ", "W:two", "S:\t", "W:three", "S:\n" }));
+  // multi-byte characters stay inside words, every ideograph is a word of its own
+  split("caf\xC3\xA9 \xE4\xB8\xAD\xE6\x96\x87x\xF0\x9F\x98\x80");
+  assert((pieces == std::vector<std::string>{ "W:caf\xC3\xA9", "S: ", "W:\xE4\xB8\xAD", "W:\xE6\x96\x87", "W:x\xF0\x9F\x98\x80" }));
+  // U+4DFF and U+9FCD are outside of the range
+  split("\xE4\xB7\xBF\xE9\xBF\x8D");
+  assert((pieces == std::vector<std::string>{ "W:\xE4\xB7\xBF\xE9\xBF\x8D" }));
+  // truncated sequence at the end of the text
+  split("a\xE4\xB8");
+  assert((pieces == std::vector<std::string>{ "W:a\xE4\xB8" }));
+
+  context ctx;
+  container_test container;
+  document::ptr doc = document::createFromUTF8("<p>a b\xE4\xB8\xAD" "c</p>", &container, &ctx);
+  element::ptr p = doc->root()->select_one(_t("p"));
+  assert(p->get_children_count() == 1);
+  tstring text;
+  p->get_child(0)->get_text(text);
+  assert(text == litehtml_from_utf8("a b\xE4\xB8\xAD" "c"));
+}
+
+// Byte-at-a-time decoder utf8_to_wchar is expected to match, malformed input included
+static std::wstring decode_utf8_reference(const char* str) {
+  const byte* p = (const byte*)str;
+  auto getb = [&p]() -> ucode_t { return *p ? *p++ : 0; };
+  std::wstring ret;
+  while (true) {
+    ucode_t b1 = getb();
+    ucode_t ch;
+    if (!b1) break;
+    if ((b1 & 0x80) == 0) {
+      ch = b1;
+    } else if ((b1 & 0xE0) == 0xC0) {
+      ch = (b1 & 0x1F) << 6;
+      ch |= getb() & 0x3F;
+    } else if ((b1 & 0xF0) == 0xE0) {
+      ch = (b1 & 0x0F) << 12;
+      ch |= (getb() & 0x3F) << 6;
+      ch |= getb() & 0x3F;
+    } else if ((b1 & 0xF8) == 0xF0) {
+      ucode_t b2 = getb() & 0x3F, b3 = getb() & 0x3F, b4 = getb() & 0x3F;
+      ch = ((b1 & 7) << 18) | (b2 << 12) | (b3 << 6) | b4;
+    } else {
+      ch = '?';
+    }
+    if (!ch) break;
+    ret += (wchar_t)ch;
+  }
+  return ret;
+}
+
+static void Utf8ToWcharTest() {
+  const char* samples[] = {
+    "",
+    "plain ascii",
+    "a longer ascii string that spans several vector blocks of sixteen bytes",
+    "caf\xC3\xA9 na\xC3\xAFve \xE4\xB8\xAD\xE6\x96\x87 \xF0\x9F\x98\x80 and ascii after the multi-byte part",
+    "0123456789abcde\xC3\xA9" "0123456789abcdef",
+    // stray continuation bytes, invalid lead bytes, overlong and truncated sequences
+    "\x80\xBF" "abc\xF8\xFF\xFE" "def",
+    "\xC3" "x\xE4\xB8" "y\xF0\x9F\x98" "z",
+    "overlong \xC0\xAF and nul \xC0\x80 stops decoding",
+    "ends with a truncated sequence \xE4\xB8",
+    "ends with a lead byte \xF0",
+  };
+  for (const char* sample : samples) {
+    assert(std::wstring(utf8_to_wchar(sample)) == decode_utf8_reference(sample));
+  }
+  // pseudo random byte soup, mostly ASCII
+  unsigned int seed = 12345;
+  for (int i = 0; i < 200; i++) {
+    std::string str;
+    int length = i % 70;
+    for (int j = 0; j < length; j++) {
+      seed = seed * 1103515245 + 12345;
+      byte c = (byte)(seed >> 16);
+      if (c == 0 || (seed & 0x300)) c = (byte)('a' + c % 26);
+      str += (char)c;
+    }
+    assert(std::wstring(utf8_to_wchar(str.c_str())) == decode_utf8_reference(str.c_str()));
+  }
+}
+
+class text_run_container : public container_test {
+public:
+  tstring drawn;
+  int text_width(const tchar_t* text, uint_ptr hFont) override { return (int)t_strlen(text) * 10; }
+  void draw_text(uint_ptr hdc, const tchar_t* text, uint_ptr hFont, web_color color, const position& pos) override { drawn += text; drawn += _t("|"); }
+};
+
+static void TextRunTest() {
+  context ctx;
+  text_run_container container;
+  document::ptr doc = document::createFromUTF8("<style>div, pre { display: block } pre { white-space: pre }</style>"
+    "<div>one two  three four</div><pre>a\n b</pre>", &container, &ctx);
+  element::ptr div = doc->root()->select_one(_t("div"));
+  assert(div->get_children_count() == 1 && div->get_child(0)->is_text_run());
+  std::shared_ptr<el_text_run> run = std::static_pointer_cast<el_text_run>(div->get_child(0));
+  assert(run->get_words().size() == 8);
+  assert(run->get_words()[1].is_space && !run->get_words()[2].is_space);
+
+  // the first item of a line box stays a single word, the rest of the line grows into one fragment
+  doc->render(1000);
+  assert(run->get_fragments().size() == 3);
+  assert(run->get_fragments()[2]->first_word() == 2 && run->get_fragments()[2]->last_word() == 7);
+  assert(run->get_words()[4].skip);
+
+  container.drawn.clear();
+  position clip(0, 0, 1000, 1000);
+  doc->draw(0, 0, 0, &clip);
+  assert(container.drawn == _t("one| |two| |three| |four|a| |b|"));
+
+  // "one two" is 70px wide, so every word starts a new line
+  doc->render(60);
+  assert(run->get_fragments().size() == 7);
+  int top = run->get_fragments()[0]->top();
+  assert(run->get_fragments()[1]->top() == top && run->get_fragments()[2]->top() > top);
+}
+
+static void LineBreakTest() {
+  context ctx;
+  text_run_container container;
+  document::ptr doc = document::createFromUTF8("<style>div { display: block }</style><div>a b c d e f g h i j</div>", &container, &ctx);
+  std::shared_ptr<el_text_run> run = std::static_pointer_cast<el_text_run>(doc->root()->select_one(_t("div"))->get_child(0));
+  auto line_of = [&](int word) {
+    for (const auto& fragment : run->get_fragments()) {
+      if (fragment->first_word() <= word && fragment->last_word() >= word) return fragment->top();
+    }
+    return -1;
+  };
+
+  // "a b c d e" is 90px, the words after the second one are taken into the line at once
+  doc->render(95);
+  assert(line_of(0) == line_of(8) && line_of(10) > line_of(8) && line_of(10) == line_of(18));
+  assert(run->get_fragments().size() < 10);
+  doc->render(90);
+  assert(line_of(0) == line_of(8) && line_of(10) > line_of(8));
+  doc->render(89);
+  assert(line_of(0) == line_of(6) && line_of(8) > line_of(6));
+}
+
+static void ArenaTest() {
+  arena a(256);
+  char* p1 = (char*)a.allocate(1);
+  char* p2 = (char*)a.allocate(10);
+  assert((size_t)p1 % alignof(std::max_align_t) == 0);
+  assert((size_t)p2 % alignof(std::max_align_t) == 0);
+  assert(p2 >= p1 + 1);
+  // an oversized request does not waste the rest of the current block
+  char* big = (char*)a.allocate(1000);
+  memset(big, 0, 1000);
+  char* p3 = (char*)a.allocate(10);
+  assert(p3 > p2 && p3 < p1 + 256);
+  size_t used = a.used();
+  assert(used >= 1031 && a.high_water() == used);
+  a.clear();
+  assert(a.used() == 0 && a.high_water() == used);
+  a.allocate(10);
+  assert(a.high_water() == used);
+
+  // rewind() hands out the memory of the same blocks again
+  arena b(256);
+  std::vector<char*> first;
+  for (int i = 0; i < 5; i++) {
+    first.push_back((char*)b.allocate(i ? 200 : 100));
+  }
+  b.rewind();
+  assert(b.used() == 0);
+  for (int i = 0; i < 5; i++) {
+    assert(b.allocate(i ? 200 : 100) == first[i]);
+  }
+
+  context ctx;
+  container_test container;
+  document::ptr doc = document::createFromString(_t("<html><body><p>Text</p></body></html>"), &container, &ctx);
+  size_t parsed = doc->parse_arena_high_water();
+  assert(parsed > 0);
+  doc->append_children_from_string(*doc->root(), _t("<div>More text</div>"));
+  assert(doc->parse_arena_high_water() >= parsed);
+}
+
+static void ElementArenaTest() {
+  context ctx;
+  container_test container;
+  document::ptr doc = document::createFromUTF8("<div id=\"a\"><p>text</p></div>", &container, &ctx);
+  assert(doc->elements_arena_used() > 0);
+  size_t used = doc->elements_arena_used();
+  doc->append_children_from_string(*doc->root(), _t("<span>more</span>"));
+  assert(doc->elements_arena_used() > used);
+
+  // an element that outlives its document keeps the arena alive
+  element::ptr div = doc->root()->select_one(_t("#a"));
+  doc.reset();
+  assert(!t_strcmp(div->get_tagName(), _t("div")));
+  assert(div->get_children_count() == 1);
+}
+
+// asks for elements, so the parser collects the attributes for create_element
+class element_creating_container : public container_test {
+public:
+  string_map seen;
+  bool creates_elements() const override { return true; }
+  std::shared_ptr<element> create_element(const tchar_t* tag_name, const string_map& attributes, const std::shared_ptr<document>& doc) override {
+    if (!t_strcmp(tag_name, _t("div"))) seen = attributes;
+    return 0;
+  }
+};
+
+static void AttributesTest() {
+  assert(intern_string(_t("href")) == intern_string(tstring(_t("href")).c_str()));
+  assert(intern_string(_t("href")) != intern_string(_t("src")));
+  assert(find_interned_string(_t("href")) == intern_string(_t("href")));
+
+  context ctx;
+  container_test container;
+  document::ptr doc = document::createFromUTF8("<div ID=\"x\" data-A=\"1\" class=\"a b\"></div>", &container, &ctx);
+  element::ptr div = doc->root()->select_one(_t("div"));
+  assert(!t_strcmp(div->get_attr(_t("id")), _t("x")));
+  assert(!t_strcmp(div->get_attr(_t("data-a")), _t("1")));
+  assert(div->get_attr(_t("data-b")) == 0);
+  assert(!t_strcmp(div->get_attr(_t("data-b"), _t("def")), _t("def")));
+
+  // names are case-insensitive, setting an existing attribute replaces its value
+  div->set_attr(_t("DATA-A"), _t("2"));
+  assert(!t_strcmp(div->get_attr(_t("data-a")), _t("2")));
+  assert(doc->root()->select_one(_t("[data-a=\"2\"]")) == div);
+  assert(doc->root()->select_one(_t("[data-a=\"1\"]")) == 0);
+  assert(doc->root()->select_one(_t("div.b#x")) == div);
+
+  // names from documents are not pooled, selectors still find them
+  div->set_attr(_t("data-unpooled-name"), _t("3"));
+  assert(!find_interned_string(_t("data-unpooled-name")));
+  assert(!t_strcmp(div->get_attr(_t("data-unpooled-name")), _t("3")));
+  assert(doc->root()->select_one(_t("[data-unpooled-name=\"3\"]")) == div);
+  assert(find_interned_string(_t("data-unpooled-name")));
+
+  // a name pooled after it was set still replaces the attribute
+  div->set_attr(_t("data-pooled-later"), _t("old"));
+  document::ptr other = document::createFromUTF8("<style>[data-pooled-later=new] { color: red }</style>", &container, &ctx);
+  div->set_attr(_t("data-pooled-later"), _t("new"));
+  assert(!t_strcmp(div->get_attr(_t("data-pooled-later")), _t("new")));
+  assert(doc->root()->select_one(_t("[data-pooled-later=new]")) == div);
+
+  element_creating_container creating;
+  doc = document::createFromUTF8("<div ID=\"y\" data-c=\"4\"></div>", &creating, &ctx);
+  div = doc->root()->select_one(_t("div"));
+  assert(creating.seen.size() == 2 && creating.seen[_t("data-c")] == _t("4"));
+  assert(!t_strcmp(div->get_attr(_t("id")), _t("y")) && !t_strcmp(div->get_attr(_t("data-c")), _t("4")));
+}
+
+static void CreateFromBufferTest() {
+  context ctx;
+  container_test container;
+  // a slice of a larger buffer, without a terminating NUL
+  const char html[] = "<p>one</p><p>two</p>";
+  std::vector<char> data(html, html + 10);
+  document::ptr doc = document::createFromBuffer(data.data(), data.size(), &container, &ctx);
+  assert(doc->root()->select_all(_t("p")).size() == 1);
+
+  const char* path = "createFromFileTest.html";
+  FILE* f = fopen(path, "wb");
+  assert(f);
+  fputs(html, f);
+  fclose(f);
+  doc = document::createFromFile(path, &container, &ctx);
+  assert(doc && doc->root()->select_all(_t("p")).size() == 2);
+
+  f = fopen(path, "wb");
+  fclose(f);
+  doc = document::createFromFile(path, &container, &ctx);
+  assert(doc && doc->root());
+  remove(path);
+
+  assert(!document::createFromFile("no/such/file.html", &container, &ctx));
+}
+
+static void PlainTextRunParseTest() {
+  // Plain text is taken from the tokenizer in runs; the text, positions and
+  // errors must match what per-character tokens produce.
+  const char html[] = "<p>Lorem ipsum dolor sit amet, consectetur\tadipiscing elit\r\n"
+                      "sed do &amp; caf\xC3\xA9 \x01" "end</p><b>z</b>";
+  GumboOutput* output = gumbo_parse_with_options(&kGumboDefaultOptions, html, sizeof(html) - 1);
+  assert(output->errors.length == 2);
+  const GumboVector& body = ((GumboNode*)output->root->v.element.children.data[1])->v.element.children;
+  assert(body.length == 2);
+  const GumboNode* p = (const GumboNode*)body.data[0];
+  const GumboNode* text = (const GumboNode*)p->v.element.children.data[0];
+  assert(text->type == GUMBO_NODE_TEXT);
+  assert(!strcmp(text->v.text.text, "Lorem ipsum dolor sit amet, consectetur\tadipiscing elit\n"
+                                    "sed do & caf\xC3\xA9 \xEF\xBF\xBD" "end"));
+  assert(text->v.text.original_text.length == 80);
+  assert(text->v.text.start_pos.line == 1 && text->v.text.start_pos.column == 4);
+  const GumboNode* b = (const GumboNode*)body.data[1];
+  assert(b->v.element.start_pos.line == 2);
+  assert(b->v.element.start_pos.column == 27);
+  assert(b->v.element.start_pos.offset == 87);
+  gumbo_destroy_output(&kGumboDefaultOptions, output);
+}
+
+static void MalformedUtf8ParseTest() {
+  // invalid and truncated sequences become U+FFFD with an error each, ASCII around them is unaffected
+  const char html[] = "<p>ok \xC3\xA9 \x80 \xE4\xB8 \xC0\xAF \xF0\x9F\x98\x80 \x7F end\xE4</p>";
+  GumboOutput* output = gumbo_parse_with_options(&kGumboDefaultOptions, html, sizeof(html) - 1);
+  assert(output->errors.length == 7);
+  const GumboNode* body = (const GumboNode*)output->root->v.element.children.data[1];
+  const GumboNode* p = (const GumboNode*)body->v.element.children.data[0];
+  const GumboNode* text = (const GumboNode*)p->v.element.children.data[0];
+  assert(!strcmp(text->v.text.text, "ok \xC3\xA9 \xEF\xBF\xBD \xEF\xBF\xBD \xEF\xBF\xBD\xEF\xBF\xBD \xF0\x9F\x98\x80 \xEF\xBF\xBD end\xEF\xBF\xBD"));
+  assert(text->v.text.original_text.length == 25);
+  assert(p->v.element.end_pos.column == 24 && p->v.element.end_pos.offset == 28);
+  gumbo_destroy_output(&kGumboDefaultOptions, output);
+}
+
+static void IncrementalLayoutTest() {
+  context ctx;
+  container_test container;
+  const char* style = "<style>div { display: block; height: 10px } #box { overflow: hidden; height: auto }</style>";
+  document::ptr doc = document::createFromUTF8((std::string(style) + "<div></div><div id=box><div></div></div><div id=c></div>").c_str(), &container, &ctx);
+  doc->render(100);
+  element::ptr box = doc->root()->select_one(_t("#box"));
+  element::ptr c = doc->root()->select_one(_t("#c"));
+  assert(!doc->root()->is_layout_dirty() && !box->is_layout_dirty());
+  int c_top = c->top();
+  doc->render(100);
+  assert(c->top() == c_top);
+
+  // only the changed element and its ancestors are marked
+  doc->append_children_from_utf8(*box, "<div></div>");
+  assert(box->is_layout_dirty() && doc->root()->is_layout_dirty() && !c->is_layout_dirty());
+  doc->render(100);
+  assert(!box->is_layout_dirty() && !doc->root()->is_layout_dirty());
+  assert(c->top() == c_top + 10);
+
+  document::ptr fresh = document::createFromUTF8((std::string(style) + "<div></div><div id=box><div></div><div></div></div><div id=c></div>").c_str(), &container, &ctx);
+  fresh->render(100);
+  assert(fresh->root()->select_one(_t("#c"))->top() == c->top());
+  assert(fresh->height() == doc->height());
+}
+
+static void MeasureTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("div { display: block } table { display: table } tr { display: table-row } td { display: table-cell }"));
+  container_test container;
+  document::ptr doc = document::createFromUTF8("<table><tr><td><table><tr><td id=inner><div style='width:30px;height:10px'></div></td>"
+    "<td><div style='width:20px;height:25px'></div></td></tr></table></td></tr></table>", &container, &ctx);
+  doc->render(200);
+  element::ptr inner = doc->root()->select_one(_t("#inner"));
+  position pos = inner->get_position();
+  int height = doc->height();
+  assert(inner->height() == 25);
+
+  // the widths of the table passes are kept, the boxes stay from the last layout
+  // and the element is placed at the origin as render() would do
+  assert(inner->measure(1) == 30 && inner->measure(200) == 30);
+  assert(inner->height() == 10 && inner->get_position().x == 0);
+  inner->invalidate_layout();
+  doc->render(200);
+  assert(inner->get_position().x == pos.x && inner->get_position().y == pos.y && inner->height() == 25);
+  assert(doc->height() == height);
+}
+
+static void IntrinsicWidthsTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("div { display: block } table { display: table } tr { display: table-row } td { display: table-cell }"));
+  container_test container;
+  document::ptr doc = document::createFromUTF8("<table><tr><td id=fixed><div style='width:30px;height:10px'></div></td>"
+    "<td id=percent><div style='width:50%;height:10px'></div></td></tr></table>", &container, &ctx);
+  doc->render(200);
+  element::ptr fixed = doc->root()->select_one(_t("#fixed"));
+  element::ptr percent = doc->root()->select_one(_t("#percent"));
+  assert(!fixed->is_width_dependent() && percent->is_width_dependent());
+
+  int min_width = 0, max_width = 0;
+  fixed->get_intrinsic_widths(200, min_width, max_width);
+  assert(min_width == 30 && max_width == 30);
+  // the content fits into a narrower width the same way
+  fixed->get_intrinsic_widths(100, min_width, max_width);
+  assert(min_width == 30 && max_width == 30);
+  assert(fixed->get_position().x == 0 && fixed->height() == 10);
+
+  percent->get_intrinsic_widths(200, min_width, max_width);
+  assert(max_width == 100);
+  percent->get_intrinsic_widths(100, min_width, max_width);
+  assert(max_width == 50);
+}
+
+static void FloatBandsTest() {
+  float_bands bands;
+  bands.add_left(0, 50, 100);
+  bands.add_left(20, 40, 150);
+  bands.add_right(30, 80, 400);
+  assert(bands.line_left(-1) == 0 && bands.line_left(0) == 100 && bands.line_left(20) == 150);
+  assert(bands.line_left(40) == 100 && bands.line_left(50) == 0);
+  assert(bands.line_right(29, 500) == 500 && bands.line_right(30, 500) == 400 && bands.line_right(30, 300) == 300);
+  assert(bands.line_right(80, 500) == 500);
+  // the first float top or bottom below 10 where the width fits into 500px
+  assert(bands.next_line_top(10, 300, 500) == 20);
+  assert(bands.next_line_top(10, 360, 500) == 50);
+  assert(bands.next_line_top(10, 450, 500) == 80);
+  assert(bands.next_line_top(90, 450, 500) == 90);
+}
+
+static void PartialLayoutTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("html, body, div { display: block } body { margin: 0 } div { height: 20px }"));
+  std::string html = "<html><body>";
+  for (int i = 0; i < 100; i++) {
+    html += "<div id=d" + std::to_string(i) + "></div>";
+  }
+  html += "</body></html>";
+  container_test container;
+  document::ptr doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+
+  // the layout stops after the block reaching y = 100, the rest is estimated from it
+  assert(doc->render_partial(500, 100) == 2000);
+  assert(!doc->is_layout_complete() && doc->height() == 100);
+  element::ptr d4 = doc->root()->select_one(_t("#d4"));
+  element::ptr d50 = doc->root()->select_one(_t("#d50"));
+  assert(!d4->is_layout_pending() && d4->get_placement().y == 80);
+  assert(d50->is_layout_pending() && !d50->is_visible());
+
+  assert(doc->render_partial(500, 1010) == 2000);
+  assert(!d50->is_layout_pending() && d50->get_placement().y == 1000);
+  doc->render(500);
+  assert(doc->is_layout_complete() && doc->height() == 2000);
+  assert(doc->root()->select_one(_t("#d99"))->get_placement().y == 1980);
+}
+
+static void LayoutDeadlineTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("html, body, div { display: block } body { margin: 0 } div { height: 20px }"));
+  std::string html = "<html><body>";
+  for (int i = 0; i < 100; i++) {
+    html += "<div></div>";
+  }
+  html += "</body></html>";
+  container_test container;
+  document::ptr doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+
+  // past the deadline every call lays out one more block
+  assert(doc->render_partial(500, std::chrono::steady_clock::now()) == 2000);
+  assert(!doc->is_layout_complete() && doc->height() == 20);
+  assert(doc->layout_progress() > 0.009f && doc->layout_progress() < 0.011f);
+  doc->render_partial(500, std::chrono::steady_clock::now());
+  assert(!doc->is_layout_complete() && doc->height() == 40);
+
+  std::atomic<bool> cancel(true);
+  doc->render_partial(500, std::chrono::steady_clock::now() + std::chrono::hours(1), &cancel);
+  assert(!doc->is_layout_complete());
+
+  cancel = false;
+  doc->render_partial(500, std::chrono::steady_clock::now() + std::chrono::hours(1), &cancel);
+  assert(doc->is_layout_complete() && doc->layout_progress() == 1 && doc->height() == 2000);
+
+  // the estimate grows once the second block turns out to hold several, the progress stays
+  doc = document::createFromUTF8("<html><body><div></div><div style='height:auto'><div></div><div></div><div></div><div></div></div></body></html>", &container, &ctx);
+  doc->render_partial(500, std::chrono::steady_clock::now());
+  assert(doc->height() == 20 && doc->layout_progress() == 0.5f);
+  doc->render_partial(500, std::chrono::steady_clock::now());
+  assert(doc->height() == 40 && doc->layout_progress() == 0.5f);
+}
+
+static void TaskPoolTest() {
+  task_pool pool(3);
+  std::atomic<int> sum(0);
+  // loops started from an iteration run while the outer loop waits
+  pool.run(10, [&](int i) {
+    pool.run(10, [&](int j) { sum += i * 10 + j; });
+  });
+  assert(sum == 99 * 100 / 2);
+}
+
+static void get_placements(const element::ptr& el, std::vector<position>& placements) {
+  placements.push_back(el->get_placement());
+  for (int i = 0; i < (int) el->get_children_count(); i++) {
+    get_placements(el->get_child(i), placements);
+  }
+}
+
+static void LayoutThreadsTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("div { display: block } table { display: table } tr { display: table-row } td { display: table-cell }"));
+  std::string html = "<table>";
+  for (int row = 0; row < 6; row++) {
+    html += "<tr>";
+    for (int col = 0; col < 5; col++) {
+      html += "<td><table><tr><td><div style='width:" + std::to_string(10 + row * col) + "px;height:" + std::to_string(5 + col) + "px'></div></td>"
+        "<td><div style='width:50%;height:3px'></div></td></tr></table></td>";
+    }
+    html += "</tr>";
+  }
+  html += "</table>";
+
+  std::vector<position> serial, parallel;
+  container_test container;
+  document::ptr doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+  doc->render(500);
+  get_placements(doc->root(), serial);
+
+  doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+  doc->set_layout_threads(4);
+  doc->render(500);
+  get_placements(doc->root(), parallel);
+  assert(serial.size() == parallel.size());
+  for (size_t i = 0; i < serial.size(); i++) {
+    assert(serial[i].x == parallel[i].x && serial[i].y == parallel[i].y);
+    assert(serial[i].width == parallel[i].width && serial[i].height == parallel[i].height);
+  }
+  // back to the calling thread
+  doc->set_layout_threads(0);
+  assert(!doc->layout_pool());
+}
+
+// Counts the layouts of images
+class image_counting_container : public container_test {
+public:
+  int image_sizes = 0;
+  void get_image_size(const tchar_t* src, const tchar_t* baseurl, size& sz) override {
+    image_sizes++;
+    sz.width = sz.height = 10;
+  }
+};
+
+class viewport_container : public image_counting_container {
+public:
+  int width = 800;
+  void get_client_rect(position& client) const override {
+    client.width = width;
+    client.height = 600;
+  }
+};
+
+static void ResizeTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("div { display: block } img { display: inline-block }"));
+  const char* html = "<div id=fixed style='width:300px'><img src=a.png><div style='width:50%;height:10px'></div></div>"
+    "<div id=fluid><img src=b.png><div style='width:50%;height:10px'></div></div>";
+  image_counting_container container;
+  document::ptr doc = document::createFromUTF8(html, &container, &ctx);
+  doc->render(800);
+  element::ptr fixed = doc->root()->select_one(_t("#fixed"));
+  element::ptr fluid = doc->root()->select_one(_t("#fluid"));
+  assert(!fixed->is_width_dependent() && fluid->is_width_dependent());
+
+  // the images are only asked for their size again, the fixed width block keeps its layout
+  int image_sizes = container.image_sizes;
+  doc->render(600);
+  assert(container.image_sizes == image_sizes + 3);
+
+  document::ptr fresh = document::createFromUTF8(html, &container, &ctx);
+  fresh->render(600);
+  std::vector<position> resized, rendered;
+  get_placements(doc->root(), resized);
+  get_placements(fresh->root(), rendered);
+  assert(resized.size() == rendered.size());
+  for (size_t i = 0; i < resized.size(); i++) {
+    assert(resized[i].x == rendered[i].x && resized[i].y == rendered[i].y);
+    assert(resized[i].width == rendered[i].width && resized[i].height == rendered[i].height);
+  }
+
+  // vw resolves against the new viewport, also inside a fixed width block
+  const char* vw_html = "<style>@media print { div { color: red } }</style>"
+    "<div id=vw style='width:50vw;height:10px'></div><div style='width:300px'><div id=inner style='width:25vw;height:10px'></div></div>"
+    "<div id=calc style='width:calc(50vw - 10px);height:10px'></div>";
+  viewport_container viewport;
+  doc = document::createFromUTF8(vw_html, &viewport, &ctx);
+  doc->render(800);
+  assert(doc->root()->select_one(_t("#vw"))->get_placement().width == 400);
+  assert(doc->root()->select_one(_t("#inner"))->get_placement().width == 200);
+  assert(doc->root()->select_one(_t("#calc"))->get_placement().width == 390);
+  viewport.width = 400;
+  doc->media_changed();
+  doc->render(400);
+  assert(doc->root()->select_one(_t("#vw"))->get_placement().width == 200);
+  assert(doc->root()->select_one(_t("#inner"))->get_placement().width == 100);
+  assert(doc->root()->select_one(_t("#calc"))->get_placement().width == 190);
+}
+
+static void RemovedImageTest() {
+  context ctx;
+  ctx.load_master_stylesheet(_t("div { display: block } img { display: inline-block }"));
+  image_counting_container container;
+  document::ptr doc = document::createFromUTF8("<div><img id=a src=a.png><img id=b src=b.png></div>", &container, &ctx);
+  doc->render(800);
+  element::ptr div = doc->root()->select_one(_t("div"));
+  std::weak_ptr<element> a = div->select_one(_t("#a"));
+  element::ptr b = div->select_one(_t("#b"));
+
+  // the document does not keep removed images alive nor asks for their size
+  div->removeChild(a.lock());
+  div->removeChild(b);
+  assert(a.expired());
+  int image_sizes = container.image_sizes;
+  doc->render(600);
+  assert(container.image_sizes == image_sizes);
+
+  div->appendChild(b);
+  doc->render(600);
+  assert(container.image_sizes > image_sizes);
+}
+
 void documentTest() {
   AddFontTest();
   RenderTest();
   DrawTest();
   CvtUnitsTest();
+  CalcLayoutTest();
   MouseEventsTest();
   CreateElementTest();
   DeviceChangeTest();
   ParseTest();
+  AsyncImportTest();
+  AppendStylesheetTest();
+  SplitUtf8TextTest();
+  Utf8ToWcharTest();
+  TextRunTest();
+  LineBreakTest();
+  ArenaTest();
+  ElementArenaTest();
+  AttributesTest();
+  CreateFromBufferTest();
+  PlainTextRunParseTest();
+  MalformedUtf8ParseTest();
+  IncrementalLayoutTest();
+  MeasureTest();
+  IntrinsicWidthsTest();
+  FloatBandsTest();
+  TaskPoolTest();
+  LayoutThreadsTest();
+  ResizeTest();
+  RemovedImageTest();
+  PartialLayoutTest();
+  LayoutDeadlineTest();
 }
\ No newline at end of file
@@ -158,7 +158,26 @@ static void MediaQueryParseTest() {
   q = media_query::create_from_string(_t("only screen and (max-width: 600px)"), doc);
 }
 
+static void MediaBreakpointsTest() {
+  container_test container;
+  litehtml::document::ptr doc = std::make_shared<litehtml::document>(&container, nullptr);
+  media_breakpoints bp;
+  media_query_list::create_from_string(_t("screen and (min-width: 600px), (max-width: 300px)"), doc)->add_breakpoints(bp);
+  media_query_list::create_from_string(_t("(max-width: 600px) and (min-aspect-ratio: 16/9)"), doc)->add_breakpoints(bp);
+  int_vector s1, s2;
+  media_features k = media_features();
+  k.type = media_type_screen, k.height = 100;
+  k.width = 400, bp.get_signature(k, s1);
+  k.width = 500, bp.get_signature(k, s2), assert(s1 == s2);
+  k.width = 600, bp.get_signature(k, s2), assert(s1 != s2);
+  k.width = 601, bp.get_signature(k, s1), assert(s1 != s2);
+  k.width = 900, bp.get_signature(k, s2), assert(s1 == s2);
+  k.width = 100, bp.get_signature(k, s1), assert(s1 != s2);
+  k.type = media_type_print, bp.get_signature(k, s2), assert(s1 != s2);
+}
+
 void mediaQueryTest() {
   MediaQueryCheckTest();
   MediaQueryParseTest();
+  MediaBreakpointsTest();
 }
\ No newline at end of file
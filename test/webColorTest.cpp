@@ -13,8 +13,26 @@ static void WebColorParseTest() {
   c = web_color::from_string(_t("rgb(255,0,255)"), &container), assert(c.red == 255), assert(c.green == 0), assert(c.blue == 255);
   c = web_color::from_string(_t("red"), &container), assert(c.red == 255), assert(c.green == 0), assert(c.blue == 0);
   c = web_color::from_string(_t("unknown"), &container), assert(c.red == 0), assert(c.green == 0), assert(c.blue == 0);
+  c = web_color::from_string(_t("rgba(1 2 3 / 0.5)"), &container), assert(c.red == 1), assert(c.green == 2), assert(c.blue == 3);
+  c = web_color::from_string(_t("rgba(10, 20, 30, 0.5)"), &container), assert(c.red == 10), assert(c.green == 20), assert(c.blue == 30), assert(c.alpha == 127);
+  c = web_color::from_string(_t("#1g0"), &container), assert(c.red == 0x11), assert(c.green == 0), assert(c.blue == 0);
+  c = web_color::from_string(_t("#12345"), &container), assert(c.red == 0), assert(c.green == 0), assert(c.blue == 0);
+  c = web_color::from_string(_t("transparent"), &container), assert(c.alpha == 0);
+  c = web_color::from_string(_t("LightGoldenRodYellow"), &container), assert(c.red == 0xFA), assert(c.green == 0xFA), assert(c.blue == 0xD2);
+}
+
+static void WebColorResolveNameTest() {
+  for (int i = 0; g_def_colors[i].name; i++) {
+    tstring name = g_def_colors[i].name;
+    assert(web_color::resolve_name(name.c_str(), nullptr) == g_def_colors[i].rgb);
+    lcase(name);
+    assert(web_color::resolve_name(name.c_str(), nullptr) == g_def_colors[i].rgb);
+  }
+  assert(web_color::resolve_name(_t("redd"), nullptr).empty());
+  assert(web_color::resolve_name(_t(""), nullptr).empty());
 }
 
 void webColorTest() {
   WebColorParseTest();
+  WebColorResolveNameTest();
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# Generates src/web_color_hash.inc: perfect hash of the g_def_colors names
+# (hash and displace). Run from the repository root after changing the table
+# in src/web_color.cpp:
+#     python3 tool/web_color_hash.py > src/web_color_hash.inc
+import re
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+BUCKETS = 64
+SLOTS = 256
+
+
+def color_hash(name, seed):
+    h = (FNV_OFFSET ^ seed) & 0xFFFFFFFF
+    for c in name.lower():
+        h = ((h ^ ord(c)) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def main():
+    src = open('src/web_color.cpp').read()
+    table = src[src.index('g_def_colors[]'):src.index('{0,0}')]
+    names = re.findall(r'\{_t\("([^"]+)"\)', table)
+
+    buckets = [[] for _ in range(BUCKETS)]
+    for index, name in enumerate(names):
+        buckets[color_hash(name, 0) % BUCKETS].append(index)
+
+    seeds = [0] * BUCKETS
+    slots = [-1] * SLOTS
+    # place the largest buckets first
+    for bucket in sorted(range(BUCKETS), key=lambda b: -len(buckets[b])):
+        items = buckets[bucket]
+        if not items:
+            continue
+        for seed in range(1, 65536):
+            positions = [color_hash(names[i], seed) % SLOTS for i in items]
+            if len(set(positions)) == len(positions) and all(slots[p] < 0 for p in positions):
+                break
+        else:
+            raise SystemExit('no seed found for bucket %d' % bucket)
+        seeds[bucket] = seed
+        for i, p in zip(items, positions):
+            slots[p] = i
+
+    print('// Generated by tool/web_color_hash.py from g_def_colors, do not edit.')
+    print('')
+    print('#define WEB_COLOR_HASH_BUCKETS\t%d' % BUCKETS)
+    print('#define WEB_COLOR_HASH_SLOTS\t%d' % SLOTS)
+    print('')
+    print('static const unsigned short g_color_hash_seeds[WEB_COLOR_HASH_BUCKETS] =')
+    print('{')
+    for row in range(0, BUCKETS, 16):
+        print('\t' + ', '.join('%d' % s for s in seeds[row:row + 16]) + ',')
+    print('};')
+    print('')
+    print('// index in g_def_colors or -1')
+    print('static const short g_color_hash_slots[WEB_COLOR_HASH_SLOTS] =')
+    print('{')
+    for row in range(0, SLOTS, 16):
+        print('\t' + ', '.join('%d' % s for s in slots[row:row + 16]) + ',')
+    print('};')
+
+
+if __name__ == '__main__':
+    main()